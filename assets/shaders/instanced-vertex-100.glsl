@@ -0,0 +1,26 @@
+// input vertex attributes (set by raylib)
+attribute vec3 vertexPosition;
+attribute vec2 vertexTexCoord;
+attribute vec3 vertexNormal;
+attribute vec4 vertexColor;
+attribute mat4 instanceTransform; // model matrix of each instance
+
+// input uniforms (set by raylib)
+uniform mat4 mvp;
+
+// fragment shader inputs
+varying vec3 fragPosition;
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+varying vec3 fragNormal;
+
+#include "instancing.glsl"
+
+void main() {
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+    fragPosition = instancePosition(vertexPosition);
+    fragNormal = instanceNormal(vertexNormal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
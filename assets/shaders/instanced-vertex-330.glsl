@@ -0,0 +1,28 @@
+#version 330
+
+// input vertex attributes (set by raylib)
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+in vec4 vertexColor;
+in mat4 instanceTransform; // model matrix of each instance
+
+// input uniforms (set by raylib)
+uniform mat4 mvp;
+
+// fragment shader inputs
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+out vec3 fragNormal;
+
+#include "instancing.glsl"
+
+void main() {
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+    fragPosition = instancePosition(vertexPosition);
+    fragNormal = instanceNormal(vertexNormal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
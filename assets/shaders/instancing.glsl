@@ -0,0 +1,11 @@
+// for the shaders that take the model matrix from each instance, included
+// after instanceTransform is declared
+
+vec3 instancePosition(vec3 position) {
+    return vec3(instanceTransform * vec4(position, 1.0));
+}
+
+// tiles are only scaled evenly and moved, so the model matrix works for normals
+vec3 instanceNormal(vec3 normal) {
+    return normalize(vec3(instanceTransform * vec4(normal, 0.0)));
+}
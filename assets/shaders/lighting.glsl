@@ -0,0 +1,25 @@
+// the lighting every shader shares, assets.c pastes it in for the include line.
+// the simple shaders work it out per vertex and leave out the specular highlight
+
+vec3 mainLight() { return normalize(vec3(-0.5, 1.0, -0.5)); } // from top-left
+vec3 fillLight() { return normalize(vec3(0.3, 0.6, 0.5)); } // from front-right
+
+vec3 diffuseLighting(vec3 normal) {
+    float diff1 = max(dot(normal, mainLight()), 0.0);
+    float diff2 = max(dot(normal, fillLight()), 0.0);
+
+    vec3 ambientColor = vec3(0.75, 0.80, 0.85) * 0.85;
+    vec3 diffuseColor = vec3(0.78, 0.83, 0.88) * 0.85;
+    vec3 ambient = ambientColor * 1.1;
+    vec3 diffuse = diffuseColor * (0.35 * diff1 + 0.18 * diff2);
+    return ambient + diffuse;
+}
+
+float ambientOcclusion(vec3 position, vec3 normal) {
+    // reduced height-based lighting for smoother depth
+    float heightFactor = clamp(position.y * 0.5 + 0.7, 0.85, 1.0);
+    float occlusion = clamp(0.7 + 0.2 * normal.y * heightFactor, 0.9, 1.0);
+
+    // very gentle contact shadow
+    return occlusion * clamp(1.0 - position.y * 0.05, 0.97, 1.0);
+}
@@ -0,0 +1,10 @@
+precision mediump float;
+
+varying vec2 fragTexCoord;
+varying vec3 fragLight; // worked out in the vertex shader
+
+uniform sampler2D texture0;
+
+void main() {
+    gl_FragColor = vec4(texture2D(texture0, fragTexCoord).rgb * fragLight, 1.0);
+}
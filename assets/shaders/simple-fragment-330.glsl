@@ -0,0 +1,12 @@
+#version 330
+
+in vec2 fragTexCoord;
+in vec3 fragLight; // worked out in the vertex shader
+
+uniform sampler2D texture0;
+
+out vec4 finalColor;
+
+void main() {
+    finalColor = vec4(texture(texture0, fragTexCoord).rgb * fragLight, 1.0);
+}
@@ -0,0 +1,24 @@
+// input vertex attributes (set by raylib)
+attribute vec3 vertexPosition;
+attribute vec2 vertexTexCoord;
+attribute vec3 vertexNormal;
+attribute mat4 instanceTransform; // model matrix of each instance
+
+// input uniforms (set by raylib)
+uniform mat4 mvp;
+
+// fragment shader inputs
+varying vec2 fragTexCoord;
+varying vec3 fragLight;
+
+#include "lighting.glsl"
+#include "instancing.glsl"
+
+void main() {
+    fragTexCoord = vertexTexCoord;
+    vec3 position = instancePosition(vertexPosition);
+    vec3 normal = instanceNormal(vertexNormal);
+    fragLight = diffuseLighting(normal) * ambientOcclusion(position, normal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
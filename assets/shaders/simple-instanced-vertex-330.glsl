@@ -0,0 +1,26 @@
+#version 330
+
+// input vertex attributes (set by raylib)
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+in mat4 instanceTransform; // model matrix of each instance
+
+// input uniforms (set by raylib)
+uniform mat4 mvp;
+
+// fragment shader inputs
+out vec2 fragTexCoord;
+out vec3 fragLight;
+
+#include "lighting.glsl"
+#include "instancing.glsl"
+
+void main() {
+    fragTexCoord = vertexTexCoord;
+    vec3 position = instancePosition(vertexPosition);
+    vec3 normal = instanceNormal(vertexNormal);
+    fragLight = diffuseLighting(normal) * ambientOcclusion(position, normal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
@@ -0,0 +1,24 @@
+// input vertex attributes (set by raylib)
+attribute vec3 vertexPosition;
+attribute vec2 vertexTexCoord;
+attribute vec3 vertexNormal;
+
+// input uniforms (set by raylib)
+uniform mat4 mvp;
+uniform mat4 matModel;
+uniform mat4 matNormal;
+
+// fragment shader inputs
+varying vec2 fragTexCoord;
+varying vec3 fragLight;
+
+#include "lighting.glsl"
+
+void main() {
+    fragTexCoord = vertexTexCoord;
+    vec3 position = vec3(matModel * vec4(vertexPosition, 1.0));
+    vec3 normal = normalize(vec3(matNormal * vec4(vertexNormal, 1.0)));
+    fragLight = diffuseLighting(normal) * ambientOcclusion(position, normal);
+
+    gl_Position = mvp * vec4(vertexPosition, 1.0);
+}
@@ -0,0 +1,86 @@
+#include <stddef.h>
+#include "animation.h"
+
+static float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+static float smoothstep(float t) { return t * t * (3 - 2 * t); }
+
+static int findAnimation(AnimationPool* pool, int id) {
+    for (int i = 0; i < pool->count; i++)
+        if (pool->ids[i] == id) return i;
+    return -1;
+}
+
+// move the last animation into the slot, keeping the live ones packed together
+static void removeAnimation(AnimationPool* pool, int i) {
+    int last = --pool->count;
+    pool->ids[i] = pool->ids[last];
+    pool->t[i] = pool->t[last];
+    pool->previousT[i] = pool->previousT[last];
+    pool->rate[i] = pool->rate[last];
+    pool->start[i] = pool->start[last];
+    pool->end[i] = pool->end[last];
+    pool->done[i] = pool->done[last];
+    pool->data[i] = pool->data[last];
+}
+
+int startAnimation(
+    AnimationPool* pool, Vector2 start, Vector2 end, float duration,
+    AnimationDone done, void* data) {
+    if (pool->count == MAX_ANIMATIONS) {
+        if (done != NULL) done(data);
+        return 0;
+    }
+
+    int i = pool->count++;
+    if (++pool->nextId <= 0) pool->nextId = 1; // 0 means no animation
+    pool->ids[i] = pool->nextId;
+    pool->t[i] = 0;
+    pool->previousT[i] = 0;
+    pool->rate[i] = duration > 0 ? 1 / duration : INFINITY;
+    pool->start[i] = start;
+    pool->end[i] = end;
+    pool->done[i] = done;
+    pool->data[i] = data;
+    return pool->ids[i];
+}
+
+void stopAnimation(AnimationPool* pool, int id) {
+    int i = findAnimation(pool, id);
+    if (i != -1) removeAnimation(pool, i);
+}
+
+bool isAnimationRunning(AnimationPool* pool, int id) {
+    return findAnimation(pool, id) != -1;
+}
+
+void updateAnimations(AnimationPool* pool, float deltaTime) {
+    for (int i = 0; i < pool->count; i++) {
+        pool->previousT[i] = pool->t[i];
+        pool->t[i] = fminf(pool->t[i] + deltaTime * pool->rate[i], 1);
+    }
+
+    // take the finished ones out before calling back, so the callbacks
+    // can start new animations
+    AnimationDone done[MAX_ANIMATIONS];
+    void* data[MAX_ANIMATIONS];
+    int numDone = 0;
+    for (int i = pool->count - 1; i >= 0; i--) {
+        if (pool->t[i] < 1) continue;
+        done[numDone] = pool->done[i];
+        data[numDone++] = pool->data[i];
+        removeAnimation(pool, i);
+    }
+    for (int i = numDone - 1; i >= 0; i--)
+        if (done[i] != NULL) done[i](data[i]);
+}
+
+Vector2 animationValue(AnimationPool* pool, int id, Vector2 resting, float alpha) {
+    int i = findAnimation(pool, id);
+    if (i == -1) return resting;
+    float t = smoothstep(lerp(pool->previousT[i], pool->t[i], alpha));
+    return (Vector2){
+        lerp(pool->start[i].x, pool->end[i].x, t),
+        lerp(pool->start[i].y, pool->end[i].y, t),
+    };
+}
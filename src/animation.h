@@ -8,52 +8,40 @@
 #define PLAYER_SPEED 0.1
 #define TRANSISTION_SPEED 0.25
 
+// the player's move and turn, a line of boxes and the fade, with room to spare
+#define MAX_ANIMATIONS 16
+
+// called on the update that finishes an animation
+typedef void (*AnimationDone)(void* data);
+
+// every running animation lives in one pool, each field in its own array so
+// an update is one loop over plain floats. finished animations are swapped
+// out, so only the live ones cost anything. whatever is being animated keeps
+// its own resting value and asks the pool for the value while it moves
 typedef struct {
-    float t;
-    bool isScalar;
-    bool active;
-    float duration;
-    struct { Vector2 start, end, value; } vector;
-    struct { float start, end, value; } scalar;
-} Animation;
-
-static float lerp(float a, float b, float t) { return a + (b - a) * t; }
-
-static Animation createAnimation(Vector2 value, bool isScalar, float duration) {
-    return (Animation){
-        .t = 0, .isScalar = isScalar, .active = false, .duration = duration,
-        .vector = { .start = value, .end = value, .value = value },
-        .scalar = { .start = value.x, .end = value.x, .value = value.x },
-    };
-}
-
-static void startAnimation(Animation* a, Vector2 value, bool reset) {
-    a->t = 0;
-    a->active = true;
-    if (a->isScalar) {
-        a->scalar.start = reset ? 0 : a->scalar.end;
-        a->scalar.end = value.x;
-    } else {
-        a->vector.start = reset ? (Vector2){ 0, 0 } : a->vector.end;
-        a->vector.end = value;
-    }
-}
-
-static void updateAnimation(Animation* a, float deltaTime) {
-    a->active = a->t < 1.0;
-    if (a->active) {
-        a->t = fmin(fmax(a->t + deltaTime / a->duration, 0), 1.0);
-        float smoothed = a->t * a->t * (3 - 2 * a->t); // smoothstep function
-
-        if (a->isScalar) {
-            a->scalar.value = lerp(a->scalar.start, a->scalar.end, smoothed);
-        } else {
-            a->vector.value = (Vector2){
-                lerp(a->vector.start.x, a->vector.end.x, smoothed),
-                lerp(a->vector.start.y, a->vector.end.y, smoothed),
-            };
-        }
-    }
-}
+    int count;
+    int nextId;
+    int ids[MAX_ANIMATIONS];
+    float t[MAX_ANIMATIONS];
+    float previousT[MAX_ANIMATIONS]; // before the last update, drawing goes from here to t
+    float rate[MAX_ANIMATIONS]; // 1 / duration
+    Vector2 start[MAX_ANIMATIONS];
+    Vector2 end[MAX_ANIMATIONS];
+    AnimationDone done[MAX_ANIMATIONS];
+    void* data[MAX_ANIMATIONS];
+} AnimationPool;
+
+// returns the id of the new animation. when the pool is full it finishes
+// right away and 0 comes back, which is never the id of a live animation
+int startAnimation(
+    AnimationPool* pool, Vector2 start, Vector2 end, float duration,
+    AnimationDone done, void* data);
+void stopAnimation(AnimationPool* pool, int id); // without calling its done callback
+bool isAnimationRunning(AnimationPool* pool, int id);
+void updateAnimations(AnimationPool* pool, float deltaTime);
+
+// the value part of the way between the last two updates,
+// or the resting value once the animation is over
+Vector2 animationValue(AnimationPool* pool, int id, Vector2 resting, float alpha);
 
 #endif
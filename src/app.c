@@ -1,22 +1,40 @@
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "app.h"
 #include "assets.h"
 #include "game.h"
+#include "profiler.h"
+#include "rlgl.h"
 
 // TODO: how can we make the level selection and the game info more mobile friendly?
 
+#define REDRAW_FRAMES 2 // keep drawing for a bit so both buffers hold the latest frame
+#define IDLE_WAIT_TIME (1.0 / 30) // seconds to sleep between polls while idle
+
+static const Color background = { 160, 210, 235, 255 };
+
 App* createApp() {
     App* app = calloc(1, sizeof(App));
     app->quit = false;
     app->drawingMenu = true; 
 
     app->game = createGame();
-    app->fade = createAnimation((Vector2){0, 0}, true, TRANSISTION_SPEED);
+    app->dirty = true;
+    app->quality = createQuality();
+    app->menuHover = -1;
+    app->menuStale = true;
     return app;
 }
 
 void cleanupApp(App* app) {
+    printf("skipped %ld frames while idle\n", app->skippedFrames);
+    if (saveProfile("profile-frames.csv", "profile-startup.csv") == -1)
+        printf("couldn't save the profile\n");
+    cleanupQuality(&app->quality);
+    if (app->menuTexture.id != 0) UnloadRenderTexture(app->menuTexture);
+    if (app->infoTexture.id != 0) UnloadRenderTexture(app->infoTexture);
     cleanupGame(app->game);
     free(app);
 }
@@ -46,15 +64,21 @@ void updateWindowSize(App* app) {
 #endif
 }
 
+static void startFade(App* app) {
+    app->fade = startAnimation(&app->game->animations, (Vector2){ 0, 0 },
+                               (Vector2){ 1, 0 }, TRANSISTION_SPEED, NULL, NULL);
+}
+
 // Draw a fullscreen overlay that gradually fades out over time
 void drawFadeAnimation(App* app) {
-    if (!app->fade.active) return;
+    AnimationPool* pool = &app->game->animations;
+    if (!isAnimationRunning(pool, app->fade)) return;
 
-    updateAnimation(&app->fade, GetFrameTime());
-    float alpha = 255.0 - (255.0 * app->fade.scalar.value);
+    float faded = animationValue(pool, app->fade, (Vector2){ 1, 0 }, app->game->tickAlpha).x;
+    float alpha = 255.0 - (255.0 * faded);
 
     DrawRectangle(0, 0, app->windowSize.x, app->windowSize.y,
-                  (Color){ 160, 210, 235, alpha });
+                  (Color){ background.r, background.g, background.b, alpha });
 }
 
 Color brightenColor(Color c, float amount) {
@@ -66,124 +90,210 @@ Color brightenColor(Color c, float amount) {
     return new;
 }
 
-void drawLevelSelect(App* app) {
-    Color pop = { 242, 92, 84, 255 };
-    drawText(app->game->assets, "Chickoban",
-            (Vector2){ app->windowSize.x / 2, app->windowSize.y / 3.5 },
-            65, pop, true);
+// make sure the texture matches the window, returns true when it had to be
+// created again and so holds nothing
+static bool fitTexture(RenderTexture2D* texture, Vector2 size) {
+    if (texture->id != 0 && texture->texture.width == (int)size.x &&
+        texture->texture.height == (int)size.y) return false;
+    if (texture->id != 0) UnloadRenderTexture(*texture);
+    *texture = LoadRenderTexture(size.x, size.y);
+    return true;
+}
 
+static void drawCached(RenderTexture2D texture) {
+    // render textures are upside down
+    Rectangle source = { 0, 0, texture.texture.width, -texture.texture.height };
+    DrawTextureRec(texture.texture, source, (Vector2){ 0, 0 }, WHITE);
+}
+
+static Rectangle levelButton(App* app, int level) {
     float cols = 10;
-    int rows = NUM_LEVELS / cols;
     float amount =
         cols + ((cols + 1) / 2); // The columns and the space in between them
     float w = app->windowSize.x > 1000 ? 1000 : app->windowSize.x;
     float boxSize = w / amount;
 
     float startX = ((app->windowSize.x - boxSize * amount) / 2) + (boxSize / 2);
-    Vector2 pos = { startX, app->windowSize.y / 2 - boxSize * 2.5 };
-    bool hovering = false;
-
-    for (int row = 0; row < rows; row++) {
-        for (int col = 0; col < cols; col++) {
-            int level = row * 10 + col;
-            Rectangle r = {pos.x, pos.y, boxSize, boxSize};
-            Color c = alreadySolved(app->game->assets, level)
-                ? (Color){ 98, 156, 111, 255 }
-                : (Color){ 58, 180, 172, 255 };
-
-            if (mouseInside(r)) {
-                hovering = true;
-                c = brightenColor(c, 0.2);
-                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    app->drawingMenu = false;
-                    changeLevel(app->game, level, false);
-                    startAnimation(&app->fade, (Vector2){ 1, 1 }, true);
-                    break;
-                }
-            }
-
-            DrawRectangleRounded(r, 0.2, 0, c);
-
-            const char* str = TextFormat("%d", level + 1);
-            Vector2 p = {r.x + boxSize / 2, r.y + boxSize / 2};
-            drawText(app->game->assets, str, p, 25, WHITE, true);
-
-            pos.x += boxSize * 1.5;
-        }
-        pos.y += boxSize * 1.5;
-        pos.x = startX;
+    float startY = app->windowSize.y / 2 - boxSize * 2.5;
+    int row = level / cols, col = level % (int)cols;
+    return (Rectangle){
+        startX + col * boxSize * 1.5, startY + row * boxSize * 1.5, boxSize, boxSize
+    };
+}
+
+static void drawMenuTexture(App* app) {
+    BeginTextureMode(app->menuTexture);
+    ClearBackground(background);
+
+    Color pop = { 242, 92, 84, 255 };
+    drawText(app->game->assets, "Chickoban",
+            (Vector2){ app->windowSize.x / 2, app->windowSize.y / 3.5 },
+            65, pop, true);
+
+    for (int level = 0; level < numPlayableLevels(app->game); level++) {
+        Rectangle r = levelButton(app, level);
+        Color c = alreadySolved(app->game->assets, level)
+            ? (Color){ 98, 156, 111, 255 }
+            : (Color){ 58, 180, 172, 255 };
+        if (level == app->menuHover) c = brightenColor(c, 0.2);
+        DrawRectangleRounded(r, 0.2, 0, c);
+
+        const char* str = TextFormat("%d", level + 1);
+        Vector2 p = {r.x + r.width / 2, r.y + r.height / 2};
+        drawText(app->game->assets, str, p, 25, WHITE, true);
     }
 
     Vector2 bottom = { app->windowSize.x / 2, app->windowSize.y - 50 };
     drawText(app->game->assets, "(C) 2025- @aabiji", bottom, 20, pop, true);
+    EndTextureMode();
+}
+
+void drawLevelSelect(App* app) {
+    advanceGame(app->game, true); // for the fade, the level stays as it was
+    int hover = -1;
+    for (int level = 0; level < numPlayableLevels(app->game); level++)
+        if (mouseInside(levelButton(app, level))) hover = level;
+
+    if (hover != -1 && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        app->drawingMenu = false;
+        changeLevel(app->game, hover, false);
+        startFade(app);
+    }
+
+    // the menu only changes when the window, the hovered button or the
+    // solved levels do, the rest of the time it's one textured quad
+    bool resized = fitTexture(&app->menuTexture, app->windowSize);
+    if (resized || app->menuStale || hover != app->menuHover) {
+        app->menuHover = hover;
+        app->menuStale = false;
+        drawMenuTexture(app);
+    }
+    drawCached(app->menuTexture);
     drawFadeAnimation(app);
 
-    if (hovering)
+    if (hover != -1)
         SetMouseCursor(MOUSE_CURSOR_POINTING_HAND);
     else
         SetMouseCursor(MOUSE_CURSOR_DEFAULT);
 }
 
+// the text goes over the game, so the texture is cleared to transparent.
+// the colors are stored premultiplied, which keeps the edges of the
+// glyphs from blending with the clear color twice
+static void drawInfoTexture(App* app) {
+    Color c = (Color){ 77, 109, 129, 255 };
+    BeginTextureMode(app->infoTexture);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE,
+                              RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+    app->backButton =
+        drawText(app->game->assets, "<< Back", (Vector2){15, 15}, 30, c, false);
+
+    const char* instructions[10] = {
+        "Press p to toggle the profiler",
+        "Drag a box to push it somewhere",
+        "Click on a tile to walk there",
+        "Press c to copy your moves",
+        "Press z to undo a move and y to redo it",
+        "Press m to toggle the background music",
+        "Use arrow keys to move the player",
+        "Press f to toggle fullscreen",
+        "Press Esc to quit the game",
+        "Press r to toggle restart"
+    };
+    for (int i = 0; i < 10; i++) {
+        Vector2 p = { 10, app->windowSize.y - (i + 1) * 30 };
+        drawText(app->game->assets, instructions[i], p, 20, c, false);
+    }
+
+    EndBlendMode();
+    EndTextureMode();
+}
+
 void drawGameInfo(App* app) {
     Color c = (Color){ 77, 109, 129, 255 };
 
+    if (fitTexture(&app->infoTexture, app->windowSize)) drawInfoTexture(app);
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    drawCached(app->infoTexture);
+    EndBlendMode();
+
     // go back button
-    Rectangle box =
-        drawText(app->game->assets, "<< Back", (Vector2){15, 15}, 30, c, false);
-    if (mouseInside(box)) {
+    if (mouseInside(app->backButton)) {
         SetMouseCursor(MOUSE_CURSOR_POINTING_HAND);
         if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
             app->drawingMenu = true;
-            startAnimation(&app->fade, (Vector2){1, 1}, true);
+            app->menuStale = true;
+            startFade(app);
         }
     } else {
         SetMouseCursor(MOUSE_CURSOR_DEFAULT);
     }
 
-    Level* level = &app->game->levels[app->game->level];
-    const char* info[2] = {
+    Level* level = currentLevel(app->game);
+    const char* info[3] = {
         TextFormat("Level %d", app->game->level + 1),
         TextFormat("%d / %d boxes", countCompletedGoals(level), level->numGoals),
+        "Stuck! Press r to restart",
     };
-    for (int i = 0; i < 2; i++) {
+    int numInfo = app->game->deadlocked ? 3 : 2;
+    for (int i = 0; i < numInfo; i++) {
         Vector2 p = { 10, (app->windowSize.y / 2 - 40) + i * 30 };
         drawText(app->game->assets, info[i], p, 25, c, false);
     }
-
-    const char* instructions[5] = {
-        "Press m to toggle the background music",
-        "Use arrow keys to move the player",
-        "Press f to toggle fullscreen",
-        "Press Esc to quit the game",
-        "Press r to toggle restart"
-    };
-    for (int i = 0; i < 5; i++) {
-        Vector2 p = { 10, app->windowSize.y - (i + 1) * 30 };
-        drawText(app->game->assets, instructions[i], p, 20, c, false);
-    }
 }
 
 void gameloop(App* app) {
     if (levelSolved(app->game) &&
         !alreadySolved(app->game->assets, app->game->level)) {
         markSolved(app->game->assets, app->game->level);
+        app->menuStale = true;
         changeLevel(app->game, -1, true);
-        startAnimation(&app->fade, (Vector2){1, 1}, true);
+        startFade(app);
         return;
     }
 
+    beginPhase(Draw3DPhase);
+    advanceGame(app->game, false);
+    updateCamera(app->game);
+    beginScene(&app->quality, app->windowSize, background);
     BeginMode3D(app->game->camera);
     BeginShaderMode(app->game->assets->shader);
     drawGame(app->game);
     EndShaderMode();
     EndMode3D();
+    endScene(&app->quality, app->windowSize);
+    endPhase(Draw3DPhase);
 
+    beginPhase(Draw2DPhase);
     drawGameInfo(app);
     drawFadeAnimation(app);
+    endPhase(Draw2DPhase);
 }
 
 void move(App* app, int directionX, int directionY) {
-    movePlayer(app->game, directionX, directionY); 
+    stopSolution(app->game); // the player took over
+    queueMove(app->game, directionX, directionY);
+}
+
+// walk the player to the tile that was clicked or tapped, and show the way
+// to the one under the mouse. pressing on a box drags it somewhere instead
+void handleMouseMove(App* app) {
+    Game* game = app->game;
+    bool overButton = mouseInside(app->backButton);
+    int cell = overButton ? -1 : cellAtScreen(game, GetMousePosition());
+
+    if (cell != -1 && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !startDrag(game, cell)) {
+        stopSolution(game);
+        walkTo(game, cell);
+    }
+    if (game->draggedBox != -1) {
+        if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) dragBoxTo(game, cell);
+        else dropBox(game);
+    }
+    game->hoverCell = game->draggedBox == -1 ? cell : -1;
 }
 
 void handleInput(App* app) {
@@ -196,34 +306,105 @@ void handleInput(App* app) {
 
     if (IsKeyPressed(KEY_F)) togglefullscreen(app->game->assets);
     if (IsKeyPressed(KEY_M)) togglePlayBgMusic(app->game->assets);
+    if (IsKeyPressed(KEY_P)) toggleProfiler();
     if (IsKeyPressed(KEY_RIGHT)) move(app, 1, 0);
     if (IsKeyPressed(KEY_LEFT)) move(app, -1, 0);
     if (IsKeyPressed(KEY_UP)) move(app, 0, -1);
     if (IsKeyPressed(KEY_DOWN)) move(app, 0, 1);
+    if (IsKeyPressed(KEY_Z) || IsKeyPressed(KEY_BACKSPACE)) {
+        stopSolution(app->game);
+        undoMove(app->game);
+    }
+    if (IsKeyPressed(KEY_C)) copyMoves(app->game);
+    if (IsKeyPressed(KEY_Y)) {
+        stopSolution(app->game);
+        redoMove(app->game);
+    }
+
+    if (!app->drawingMenu) handleMouseMove(app);
 
     if (IsKeyPressed(KEY_R)) {
-        restartLevel(&app->game->levels[app->game->level]);
+        restartLevel(currentLevel(app->game));
         changeLevel(app->game, app->game->level, false);
     }
 }
 
+// anything that could change what's on screen: input, animations or the window
+bool needsRedraw(App* app) {
+    bool focused = IsWindowFocused();
+    bool input =
+        GetKeyPressed() != 0 || GetTouchPointCount() > 0 ||
+        IsMouseButtonPressed(MOUSE_LEFT_BUTTON) ||
+        IsMouseButtonReleased(MOUSE_LEFT_BUTTON) ||
+        GetMouseWheelMove() != 0 ||
+        Vector2Length(GetMouseDelta()) > 0; // hovering changes the buttons
+    bool window = IsWindowResized() || focused != app->focused;
+    app->focused = focused;
+    bool fading = isAnimationRunning(&app->game->animations, app->fade);
+
+    if (app->dirty || input || window || fading || isAnimating(app->game))
+        app->redrawFrames = REDRAW_FRAMES;
+    app->dirty = false;
+    return app->redrawFrames > 0;
+}
+
 void updateApp(void* data) {
     App* app = (App*)data;
+    double frameStart = GetTime();
+    beginFrame();
 
+    beginPhase(InputPhase);
     handleInput(app);
-    updateWindowSize(app);
+    endPhase(InputPhase);
 
-    updateSound(
-        app->game->assets, BackgroundMusic,
-        app->game->assets->data.playBgMusic);
+    beginPhase(WindowPhase);
+    updateWindowSize(app);
+    endPhase(WindowPhase);
+
+    beginPhase(SoundPhase);
+    updateMusic(app->game->assets, app->game->assets->data.playBgMusic);
+    endPhase(SoundPhase);
+
+    // leave the last frame on screen and wait for something to happen.
+    // the music stream gets refilled from here, so only block on
+    // events when it's off. the browser paces the loop on the web
+    if (!needsRedraw(app)) {
+        dropFrame();
+        app->skippedFrames++;
+#if defined(PLATFORM_DESKTOP)
+        if (app->game->assets->data.playBgMusic) WaitTime(IDLE_WAIT_TIME);
+        else EnableEventWaiting();
+#endif
+        PollInputEvents();
+        app->lastFrame = GetTime(); // the wait isn't time the game should catch up on
+        return;
+    }
+    DisableEventWaiting();
+    app->redrawFrames--;
+    app->game->frameTime = frameStart - app->lastFrame;
+    app->lastFrame = frameStart;
 
     BeginDrawing();
-    ClearBackground((Color){ 160, 210, 235, 255 });
+    ClearBackground(background);
 
+    Phase phase = app->drawingMenu ? MenuPhase : GameloopPhase;
+    beginPhase(phase);
     if (app->drawingMenu)
         drawLevelSelect(app);
     else
         gameloop(app);
+    endPhase(phase);
+    drawProfiler(app->windowSize, app->skippedFrames);
+    double workTime = GetTime() - frameStart;
 
+    // includes waiting on the frame limiter and the swap
+    beginPhase(PresentPhase);
     EndDrawing();
+    endPhase(PresentPhase);
+    endFrame();
+
+    // only the game is heavy enough to need a lower quality. the wait for
+    // vsync would make every frame look as slow as the refresh rate
+    bool changed = !app->drawingMenu && updateQuality(&app->quality, workTime);
+    if (changed) useSimpleShading(app->game->assets, app->quality.tier >= SimpleShading);
 }
@@ -2,13 +2,30 @@
 #define APP_H
 
 #include "game.h"
+#include "quality.h"
 
 typedef struct {
     Game* game;
-    Animation fade;
+    int fade; // in the game's animation pool, 0 when there's none
     Vector2 windowSize;
     bool quit;
     bool drawingMenu;
+
+    // frames are only drawn when something on screen could have changed
+    bool dirty; // set from outside the loop, like when the canvas is resized
+    int redrawFrames; // frames left to draw after the last change
+    bool focused;
+    long skippedFrames;
+    double lastFrame; // when the last frame started, or the last poll while idle
+
+    Quality quality; // lowered when the frames take too long
+
+    // ui that rarely changes, drawn into textures and only redrawn when it does
+    RenderTexture2D menuTexture;
+    int menuHover; // level button under the mouse, -1 for none
+    bool menuStale; // the solved levels changed
+    RenderTexture2D infoTexture; // the back button and the instructions
+    Rectangle backButton;
 } App;
 
 App* createApp();
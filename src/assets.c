@@ -3,7 +3,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <raylib.h>
+#include <raymath.h>
 #include "assets.h"
+#include "profiler.h"
 
 #if defined(PLATFORM_WEB)
     #define GLSL_VERSION 100
@@ -28,18 +30,170 @@ void loadSaveData(AssetManager* am) {
     }
 }
 
+// models get cached in a binary format after the first launch, so the obj
+// files only get parsed once. each mesh is stored as its vertex count, then
+// the position, normal and texture coordinates of each vertex side by side
+#define MESH_CACHE_MAGIC "CKBMESH2"
+#define MESH_CACHE_FLOATS 8 // floats per vertex
+
+typedef struct {
+    char magic[8];
+    uint64_t objHash; // of the obj file's contents, a changed obj replaces the cache
+    int32_t meshCount;
+    BoundingBox bounds; // of the first mesh
+} MeshCacheHeader;
+
+static void meshCachePath(const char* objPath, char* out, int size) {
+#if defined(PLATFORM_WEB)
+    snprintf(out, size, "/game-data/%s", GetFileNameWithoutExt(objPath));
+#else
+    snprintf(out, size, "%s", objPath);
+    char* extension = strrchr(out, '.');
+    if (extension != NULL) *extension = '\0';
+#endif
+    strncat(out, ".mesh", size - strlen(out) - 1);
+}
+
+// the normal of each triangle, for meshes that came without any
+static void flatNormal(Mesh mesh, int vertex, float* normal) {
+    float* v = &mesh.vertices[(vertex - vertex % 3) * 3];
+    Vector3 a = { v[0], v[1], v[2] }, b = { v[3], v[4], v[5] }, c = { v[6], v[7], v[8] };
+    Vector3 n = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(b, a), Vector3Subtract(c, a)));
+    normal[0] = n.x;
+    normal[1] = n.y;
+    normal[2] = n.z;
+}
+
+// fnv-1a over the obj file. modification times can't be used since the web
+// build gets a fresh copy of every asset each time the page loads
+static uint64_t hashFile(const char* path) {
+    int size = 0;
+    unsigned char* data = LoadFileData(path, &size);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    UnloadFileData(data);
+    return hash;
+}
+
+static bool saveMeshCache(const char* cachePath, uint64_t objHash, Model model) {
+    size_t size = sizeof(MeshCacheHeader);
+    for (int m = 0; m < model.meshCount; m++) {
+        Mesh mesh = model.meshes[m];
+        int count = mesh.indices ? mesh.triangleCount * 3 : mesh.vertexCount;
+        size += sizeof(int32_t) + count * MESH_CACHE_FLOATS * sizeof(float);
+    }
+
+    unsigned char* data = malloc(size);
+    if (data == NULL) return false;
+    MeshCacheHeader header = { .objHash = objHash, .meshCount = model.meshCount };
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.bounds = GetMeshBoundingBox(model.meshes[0]);
+    memcpy(data, &header, sizeof(header));
+
+    // indexed meshes are written out one vertex per corner
+    unsigned char* out = data + sizeof(header);
+    for (int m = 0; m < model.meshCount; m++) {
+        Mesh mesh = model.meshes[m];
+        int32_t count = mesh.indices ? mesh.triangleCount * 3 : mesh.vertexCount;
+        memcpy(out, &count, sizeof(count));
+        float* vertex = (float*)(out + sizeof(count));
+        for (int i = 0; i < count; i++, vertex += MESH_CACHE_FLOATS) {
+            int src = mesh.indices ? mesh.indices[i] : i;
+            memcpy(vertex, &mesh.vertices[src * 3], 3 * sizeof(float));
+            if (mesh.normals) memcpy(vertex + 3, &mesh.normals[src * 3], 3 * sizeof(float));
+            else flatNormal(mesh, i, vertex + 3);
+            if (mesh.texcoords) memcpy(vertex + 6, &mesh.texcoords[src * 2], 2 * sizeof(float));
+            else vertex[6] = vertex[7] = 0;
+        }
+        out = (unsigned char*)vertex;
+    }
+
+    bool saved = SaveFileData(cachePath, data, size);
+    free(data);
+    return saved;
+}
+
+// read the whole cache at once and hand the meshes to the gpu
+static bool loadMeshCache(
+    const char* cachePath, uint64_t objHash, Model* model, BoundingBox* bounds) {
+    int size = 0;
+    unsigned char* data = FileExists(cachePath) ? LoadFileData(cachePath, &size) : NULL;
+    if (data == NULL) return false;
+
+    MeshCacheHeader header;
+    bool valid = size >= (int)sizeof(header);
+    if (valid) memcpy(&header, data, sizeof(header));
+    valid = valid && memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.objHash == objHash && header.meshCount > 0;
+    if (!valid) {
+        UnloadFileData(data);
+        return false;
+    }
+
+    Model result = { .transform = MatrixIdentity(), .meshCount = header.meshCount };
+    result.meshes = MemAlloc(header.meshCount * sizeof(Mesh));
+    result.materialCount = 1;
+    result.materials = MemAlloc(sizeof(Material));
+    result.materials[0] = LoadMaterialDefault();
+    result.meshMaterial = MemAlloc(header.meshCount * sizeof(int));
+
+    unsigned char* in = data + sizeof(header);
+    unsigned char* end = data + size;
+    for (int m = 0; m < header.meshCount && valid; m++) {
+        int32_t count = 0;
+        if (end - in >= (long)sizeof(count)) memcpy(&count, in, sizeof(count));
+        in += sizeof(count);
+        valid = count > 0 && end - in >= (long)(count * MESH_CACHE_FLOATS * sizeof(float));
+        if (!valid) break;
+
+        Mesh* mesh = &result.meshes[m];
+        mesh->vertexCount = count;
+        mesh->triangleCount = count / 3;
+        mesh->vertices = MemAlloc(count * 3 * sizeof(float));
+        mesh->normals = MemAlloc(count * 3 * sizeof(float));
+        mesh->texcoords = MemAlloc(count * 2 * sizeof(float));
+        for (int i = 0; i < count; i++, in += MESH_CACHE_FLOATS * sizeof(float)) {
+            memcpy(&mesh->vertices[i * 3], in, 3 * sizeof(float));
+            memcpy(&mesh->normals[i * 3], in + 3 * sizeof(float), 3 * sizeof(float));
+            memcpy(&mesh->texcoords[i * 2], in + 6 * sizeof(float), 2 * sizeof(float));
+        }
+        UploadMesh(mesh, false);
+    }
+
+    UnloadFileData(data);
+    if (!valid) {
+        UnloadModel(result);
+        return false;
+    }
+    *model = result;
+    *bounds = header.bounds;
+    return true;
+}
+
 ModelAsset loadModel(AssetManager* am, Texture2D texture, const char *path) {
     ModelAsset asset;
-    asset.model = LoadModel(path);
+    char cachePath[256];
+    meshCachePath(path, cachePath, sizeof(cachePath));
+    uint64_t objHash = hashFile(path);
+
+    // parse the obj and cache it the first time around
+    BoundingBox bounds;
+    if (!loadMeshCache(cachePath, objHash, &asset.model, &bounds)) {
+        asset.model = LoadModel(path);
+        bounds = GetMeshBoundingBox(asset.model.meshes[0]);
+        if (saveMeshCache(cachePath, objHash, asset.model)) {
+            UnloadModel(asset.model);
+            if (!loadMeshCache(cachePath, objHash, &asset.model, &bounds))
+                asset.model = LoadModel(path);
+        }
+    }
 
     asset.model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
     asset.model.materials[0].shader = am->shader;
 
-    Mesh mesh = asset.model.meshes[0];
-    if (mesh.normals == NULL)
-        GenMeshTangents(&mesh);
-
-    BoundingBox bounds = GetMeshBoundingBox(asset.model.meshes[0]);
     asset.size = (Vector3){
         bounds.max.x - bounds.min.x,
         bounds.max.y - bounds.min.y,
@@ -47,7 +201,6 @@ ModelAsset loadModel(AssetManager* am, Texture2D texture, const char *path) {
     };
 
     bool isBox = strcmp(path, "assets/models/box/box1.vox.obj") == 0;
-    printf("%d\n", isBox);
     Vector3 targetSize = isBox ? am->boxSize : am->tileSize;
 
     // scale with correct aspect ratio
@@ -60,20 +213,139 @@ ModelAsset loadModel(AssetManager* am, Texture2D texture, const char *path) {
     return asset;
 }
 
+// stack the palettes on top of each other in one texture, so every model
+// gets drawn with the same texture bound. regions gets where each palette
+// ended up, in texture coordinates
+static Texture2D loadAtlas(char** paths, Rectangle* regions) {
+    Image images[NumModels];
+    int width = 0, height = 0;
+    for (int i = 0; i < NumModels; i++) {
+        images[i] = LoadImage(TextFormat("%s.png", paths[i]));
+        ImageFormat(&images[i], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        width = fmax(width, images[i].width);
+        height += images[i].height;
+    }
+
+    Image atlas = GenImageColor(width, height, BLANK);
+    int y = 0;
+    for (int i = 0; i < NumModels; i++) {
+        Image image = images[i];
+        for (int row = 0; row < image.height; row++) {
+            unsigned char* dest = (unsigned char*)atlas.data + (y + row) * width * 4;
+            unsigned char* src = (unsigned char*)image.data + row * image.width * 4;
+            memcpy(dest, src, image.width * 4);
+        }
+        regions[i] = (Rectangle){
+            0, (float)y / height, (float)image.width / width, (float)image.height / height
+        };
+        y += image.height;
+        UnloadImage(image);
+    }
+
+    Texture2D texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    return texture;
+}
+
+// point a model's texture coordinates at its palette in the atlas. the mesh
+// cache keeps the original ones, so the atlas layout can change freely
+static void remapTexcoords(Model model, Rectangle region) {
+    for (int m = 0; m < model.meshCount; m++) {
+        Mesh mesh = model.meshes[m];
+        if (mesh.texcoords == NULL) continue;
+        for (int i = 0; i < mesh.vertexCount; i++) {
+            mesh.texcoords[i * 2] = region.x + mesh.texcoords[i * 2] * region.width;
+            mesh.texcoords[i * 2 + 1] = region.y + mesh.texcoords[i * 2 + 1] * region.height;
+        }
+        UpdateMeshBuffer(mesh, 1, mesh.texcoords, mesh.vertexCount * 2 * sizeof(float), 0);
+    }
+}
+
+// glsl has no includes, so each #include "file" line is replaced with that file
+// from the shaders folder. it keeps the code the shaders share in one place
+static char* loadShaderSource(const char* name) {
+    char* text = LoadFileText(TextFormat("assets/shaders/%s", name));
+    if (text == NULL) return NULL;
+    char* source = strdup(text);
+    UnloadFileText(text);
+
+    // only at the start of a line, the comments can mention includes
+    const char* directive = "\n#include \"";
+    char* include;
+    while ((include = strstr(source, directive)) != NULL) {
+        include++; // keep the newline
+        char* start = include + strlen(directive) - 1;
+        char* end = strchr(start, '"');
+        if (end == NULL) break;
+        char file[64];
+        snprintf(file, sizeof(file), "%.*s", (int)(end - start), start);
+        char* rest = strchr(end, '\n');
+        if (rest == NULL) rest = end + 1;
+
+        char* included = LoadFileText(TextFormat("assets/shaders/%s", file));
+        if (included == NULL) {
+            free(source);
+            return NULL;
+        }
+        size_t before = include - source;
+        char* expanded = malloc(before + strlen(included) + strlen(rest) + 1);
+        memcpy(expanded, source, before);
+        strcpy(expanded + before, included);
+        strcat(expanded, rest);
+        UnloadFileText(included);
+        free(source);
+        source = expanded;
+    }
+    return source;
+}
+
+// the shaders come in a version for each glsl, like vertex-330.glsl
+static Shader loadShaderFiles(const char* vertexName, const char* fragName) {
+    char* vertex = loadShaderSource(TextFormat("%s-%d.glsl", vertexName, GLSL_VERSION));
+    char* fragment = loadShaderSource(TextFormat("%s-%d.glsl", fragName, GLSL_VERSION));
+    Shader shader = LoadShaderFromMemory(vertex, fragment);
+    free(vertex);
+    free(fragment);
+    return shader;
+}
+
+static Shader loadInstancedShader(const char* vertexName, const char* fragName) {
+    Shader shader = loadShaderFiles(vertexName, fragName);
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+    return shader;
+}
+
 AssetManager* loadAssets() {
     AssetManager* am = calloc(1, sizeof(AssetManager));
     am->tileSize = (Vector3){2.5, 2.5, 2.5};
     am->boxSize = (Vector3){2.0, 2.0, 2.0};
+
+    double start = GetTime();
     am->font = LoadFont("assets/puffy.otf");
+    recordStartupPhase("font", start);
+
+    start = GetTime();
+    am->shader = loadShaderFiles("vertex", "fragment");
+    am->instancedShader = loadInstancedShader("instanced-vertex", "fragment");
 
-    const char* vertexName = TextFormat("assets/shaders/vertex-%d.glsl", GLSL_VERSION);
-    const char* fragName = TextFormat("assets/shaders/fragment-%d.glsl", GLSL_VERSION);
-    am->shader = LoadShader(vertexName, fragName);
+    // lit per vertex, for when the game can't keep up
+    am->simpleShader = loadShaderFiles("simple-vertex", "simple-fragment");
+    am->simpleInstancedShader =
+        loadInstancedShader("simple-instanced-vertex", "simple-fragment");
+    recordStartupPhase("shaders", start);
 
+    start = GetTime();
     am->sounds[MoveSfx] = LoadSound("assets/sounds/step.wav");
     am->sounds[PushSfx] = LoadSound("assets/sounds/pop.mp3");
     am->sounds[SuccessSfx] = LoadSound("assets/sounds/success.mp3");
-    am->sounds[BackgroundMusic] = LoadSound("assets/sounds/sunshine.mp3");
+    for (int i = 0; i < NumSounds; i++)
+        for (int v = 0; v < NUM_VOICES; v++)
+            am->voices[i][v] = LoadSoundAlias(am->sounds[i]);
+
+    SetAudioStreamBufferSizeDefault(MUSIC_BUFFER_FRAMES);
+    am->music = LoadMusicStream("assets/sounds/sunshine.mp3");
+    PlayMusicStream(am->music); // paused by updateMusic if it's turned off
+    recordStartupPhase("sounds", start);
 
     loadSaveData(am);
 
@@ -84,34 +356,170 @@ AssetManager* loadAssets() {
         "assets/models/box/box1.vox",
         "assets/models/chicken/chicken.vox"
     };
+    start = GetTime();
+    Rectangle regions[NumModels];
+    am->atlas = loadAtlas(paths, regions);
+    recordStartupPhase("atlas", start);
+
     for (int i = 0; i < NumModels; i++) {
-        am->textures[i] = LoadTexture(TextFormat("%s.png", paths[i]));
+        start = GetTime();
         const char* path = TextFormat("%s.obj", paths[i]);
-        am->assets[i] = loadModel(am, am->textures[i], path);
+        am->assets[i] = loadModel(am, am->atlas, path);
+        remapTexcoords(am->assets[i].model, regions[i]);
+        recordStartupPhase(paths[i], start);
     }
 
+    // every model shares the atlas, so these work for all of them
+    am->material = am->assets[0].model.materials[0];
+    am->instancedMaterial = am->material;
+    am->instancedMaterial.shader = am->instancedShader;
+
     return am;
 }
 
+Vector3 getModelPosition(
+    AssetManager* am, ModelType type, Vector3 offset,
+    Vector2 position, bool offsetHeight) {
+    return (Vector3){
+        offset.x + position.x * am->tileSize.x,
+        offsetHeight ? am->assets[type].size.y + offset.y : -offset.y,
+        offset.z + position.y * am->tileSize.z
+    };
+}
+
+// the same transform DrawModelEx builds: scale, rotate around y, then translate
+Matrix getModelTransform(
+    AssetManager* am, ModelType type, Vector3 offset,
+    Vector2 position, float rotation, bool offsetHeight) {
+    ModelAsset asset = am->assets[type];
+    Vector3 realPos = getModelPosition(am, type, offset, position, offsetHeight);
+    Matrix scale = MatrixScale(asset.scaleFactor.x, asset.scaleFactor.y, asset.scaleFactor.z);
+    Matrix rotate = MatrixRotate((Vector3){ 0, 1, 0 }, rotation * DEG2RAD);
+    Matrix translate = MatrixTranslate(realPos.x, realPos.y, realPos.z);
+    Matrix transform = MatrixMultiply(MatrixMultiply(scale, rotate), translate);
+    return MatrixMultiply(asset.model.transform, transform);
+}
+
 void drawModel(
     AssetManager* am, ModelType type, Vector3 offset,
     Vector2 position, float rotation, bool offsetHeight) {
     ModelAsset asset = am->assets[type];
     Vector3 axis = { 0, 1, 0 };
-    Vector3 realPos = {
-        offset.x + position.x * am->tileSize.x,
-        offsetHeight ? asset.size.y + offset.y : -offset.y,
-        offset.z + position.y * am->tileSize.z
-    };
+    Vector3 realPos = getModelPosition(am, type, offset, position, offsetHeight);
     DrawModelEx(asset.model, realPos, axis, rotation, asset.scaleFactor, WHITE);
+    for (int i = 0; i < asset.model.meshCount; i++)
+        countDrawCall(asset.model.meshes[i].triangleCount);
 }
 
-void updateSound(AssetManager* am, Sounds sound, bool play) {
-    bool alreadyPlaying = IsSoundPlaying(am->sounds[sound]);
-    if (!alreadyPlaying && play)
-        PlaySound(am->sounds[sound]);
-    else if (alreadyPlaying && !play)
-        StopSound(am->sounds[sound]);
+// draw every copy of a model with one draw call per mesh
+void drawModelInstances(
+    AssetManager* am, ModelType type, Matrix* transforms, int count) {
+    if (count == 0) return;
+    Model model = am->assets[type].model;
+    for (int i = 0; i < model.meshCount; i++) {
+        DrawMeshInstanced(model.meshes[i], am->instancedMaterial, transforms, count);
+        countDrawCall(model.meshes[i].triangleCount * count);
+    }
+}
+
+// merge the copies of every model into one mesh with the transforms already
+// applied, indexed by model type. the models share the atlas, so it draws with
+// a single call. the result isn't indexed, so it can hold any number of vertices
+Mesh bakeModels(AssetManager* am, Matrix** transforms, int* counts) {
+    Mesh baked = { 0 };
+    for (int type = 0; type < NumModels; type++) {
+        Model model = am->assets[type].model;
+        for (int m = 0; m < model.meshCount; m++) {
+            Mesh mesh = model.meshes[m];
+            int n = mesh.indices ? mesh.triangleCount * 3 : mesh.vertexCount;
+            baked.vertexCount += n * counts[type];
+        }
+    }
+    if (baked.vertexCount == 0) return baked;
+
+    baked.triangleCount = baked.vertexCount / 3;
+    baked.vertices = MemAlloc(baked.vertexCount * 3 * sizeof(float));
+    baked.normals = MemAlloc(baked.vertexCount * 3 * sizeof(float));
+    baked.texcoords = MemAlloc(baked.vertexCount * 2 * sizeof(float));
+
+    int v = 0;
+    for (int type = 0; type < NumModels; type++) {
+        Model model = am->assets[type].model;
+        for (int c = 0; c < counts[type]; c++) {
+            Matrix t = transforms[type][c];
+            for (int m = 0; m < model.meshCount; m++) {
+                Mesh mesh = model.meshes[m];
+                int n = mesh.indices ? mesh.triangleCount * 3 : mesh.vertexCount;
+
+                for (int i = 0; i < n; i++, v++) {
+                    int src = mesh.indices ? mesh.indices[i] : i;
+                    Vector3 p = {
+                        mesh.vertices[src * 3], mesh.vertices[src * 3 + 1],
+                        mesh.vertices[src * 3 + 2]
+                    };
+                    p = Vector3Transform(p, t);
+                    baked.vertices[v * 3] = p.x;
+                    baked.vertices[v * 3 + 1] = p.y;
+                    baked.vertices[v * 3 + 2] = p.z;
+
+                    // normals only get rotated and scaled
+                    Vector3 normal = { 0, 1, 0 };
+                    if (mesh.normals) {
+                        Vector3 a = {
+                            mesh.normals[src * 3], mesh.normals[src * 3 + 1],
+                            mesh.normals[src * 3 + 2]
+                        };
+                        normal = Vector3Normalize((Vector3){
+                            t.m0 * a.x + t.m4 * a.y + t.m8 * a.z,
+                            t.m1 * a.x + t.m5 * a.y + t.m9 * a.z,
+                            t.m2 * a.x + t.m6 * a.y + t.m10 * a.z,
+                        });
+                    }
+                    baked.normals[v * 3] = normal.x;
+                    baked.normals[v * 3 + 1] = normal.y;
+                    baked.normals[v * 3 + 2] = normal.z;
+
+                    if (mesh.texcoords) {
+                        baked.texcoords[v * 2] = mesh.texcoords[src * 2];
+                        baked.texcoords[v * 2 + 1] = mesh.texcoords[src * 2 + 1];
+                    }
+                }
+            }
+        }
+    }
+
+    UploadMesh(&baked, false);
+    return baked;
+}
+
+void drawBakedModels(AssetManager* am, Mesh mesh) {
+    if (mesh.vertexCount == 0) return;
+    DrawMesh(mesh, am->material, MatrixIdentity());
+    countDrawCall(mesh.triangleCount);
+}
+
+// switch every material between the full shaders and the ones lit per vertex
+void useSimpleShading(AssetManager* am, bool simple) {
+    Shader shader = simple ? am->simpleShader : am->shader;
+    for (int i = 0; i < NumModels; i++)
+        am->assets[i].model.materials[0].shader = shader;
+    am->material.shader = shader;
+    am->instancedMaterial.shader = simple ? am->simpleInstancedShader : am->instancedShader;
+}
+
+// play on the voice that started the longest time ago, so quick
+// repeats overlap and only the oldest one gets cut off
+void playSound(AssetManager* am, Sounds sound) {
+    PlaySound(am->voices[sound][am->nextVoice[sound]]);
+    am->nextVoice[sound] = (am->nextVoice[sound] + 1) % NUM_VOICES;
+}
+
+// refills the music's buffers, so it needs to run every frame, idle or not
+void updateMusic(AssetManager* am, bool play) {
+    bool playing = IsMusicStreamPlaying(am->music);
+    if (play && !playing) ResumeMusicStream(am->music);
+    if (!play && playing) PauseMusicStream(am->music);
+    if (play) UpdateMusicStream(am->music);
 }
 
 Rectangle drawText(
@@ -141,14 +549,21 @@ void markSolved(AssetManager* am, int level) { am->data.solvedLevels[level] = tr
 
 void cleanupAssets(AssetManager* am) {
     UnloadFont(am->font);
-    for (int i = 0; i < NumModels; i++) {
+    for (int i = 0; i < NumModels; i++)
         UnloadModel(am->assets[i].model);
-        UnloadTexture(am->textures[i]);
-    }
+    UnloadTexture(am->atlas);
     for (int i = 0; i < NumSounds; i++) {
-        StopSound(am->sounds[i]);
+        for (int v = 0; v < NUM_VOICES; v++) {
+            StopSound(am->voices[i][v]);
+            UnloadSoundAlias(am->voices[i][v]);
+        }
         UnloadSound(am->sounds[i]);
     }
+    StopMusicStream(am->music);
+    UnloadMusicStream(am->music);
     UnloadShader(am->shader);
+    UnloadShader(am->instancedShader);
+    UnloadShader(am->simpleShader);
+    UnloadShader(am->simpleInstancedShader);
     free(am);
 }
@@ -9,9 +9,12 @@ typedef enum {
 } ModelType;
 
 typedef enum {
-    MoveSfx, PushSfx, SuccessSfx, BackgroundMusic, NumSounds,
+    MoveSfx, PushSfx, SuccessSfx, NumSounds,
 } Sounds;
 
+#define NUM_VOICES 4 // copies of each sound that can play at once
+#define MUSIC_BUFFER_FRAMES 4096 // decoded ahead of the music that's playing
+
 typedef struct {
     bool solvedLevels[NUM_LEVELS];
     bool playBgMusic;
@@ -27,12 +30,20 @@ typedef struct {
 typedef struct {
     Font font;
     Shader shader;
+    Shader instancedShader; // takes the model matrix from each instance
+    Shader simpleShader; // cheaper versions of the two above, lit per vertex
+    Shader simpleInstancedShader;
+    Material material; // the atlas with the lighting shader
+    Material instancedMaterial;
     Sound sounds[NumSounds];
+    Sound voices[NumSounds][NUM_VOICES]; // aliases sharing the sound's samples
+    int nextVoice[NumSounds];
+    Music music; // streamed, not decoded up front
 
     Vector3 tileSize;
     Vector3 boxSize;
     ModelAsset assets[NumModels];
-    Texture textures[NumModels];
+    Texture atlas; // the palettes of all the models in one texture
 
     SaveData data;
     const char* saveFile;
@@ -41,14 +52,24 @@ typedef struct {
 AssetManager* loadAssets();
 void cleanupAssets(AssetManager* am);
 
+Matrix getModelTransform(
+    AssetManager* am, ModelType type, Vector3 offset,
+    Vector2 position, float rotation, bool offsetHeight);
 void drawModel(
     AssetManager* am, ModelType type, Vector3 offset,
     Vector2 position, float rotation, bool offsetHeight);
+void drawModelInstances(
+    AssetManager* am, ModelType type, Matrix* transforms, int count);
+
+Mesh bakeModels(AssetManager* am, Matrix** transforms, int* counts);
+void drawBakedModels(AssetManager* am, Mesh mesh);
+void useSimpleShading(AssetManager* am, bool simple);
 Rectangle drawText(
     AssetManager* am, const char* text, Vector2 position,
     int fontSize, Color color, bool center); // draw text and return its (x,y,width,height)
 
-void updateSound(AssetManager* am, Sounds sound, bool play);
+void playSound(AssetManager* am, Sounds sound);
+void updateMusic(AssetManager* am, bool play);
 
 int persistData(AssetManager* am);
 void togglefullscreen(AssetManager* am);
@@ -1,53 +1,124 @@
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "game.h"
 #include "assets.h"
 #include "levels.h"
+#include "solver.h"
+#include "profiler.h"
 #include "raylib.h"
+#include "rlgl.h"
+
+#define CHUNK_SIZE 16 // cells along each side of a chunk
+#define MIN_CAMERA_DISTANCE 45
+#define MAX_CAMERA_DISTANCE 80 // levels that don't fit from here get followed
+#define CAMERA_FOLLOW_SPEED 6 // how quickly the camera catches up to the player
 
 Game* createGame() {
     Game* game = calloc(1, sizeof(Game));
 
-    // Load the levels
-    game->levels = calloc(NUM_LEVELS, sizeof(Level));
-    int value = parseLevels("assets/levels.txt", game->levels);
-    if (value == -1) { // TODO: tell user!
+    // Load the levels, compiling them from the collection file if there's no pack
+    if (openPack("assets/levels.pack", &game->pack) == -1) {
+        Collection collection;
+        if (loadCollection("assets/levels.txt", &collection) != -1) {
+            packCollection(&collection, &game->pack);
+            freeCollection(&collection);
+        }
+    }
+    if (game->pack.numLevels < 1) { // TODO: tell user!
         printf("error loading the levels");
         exit(-1);
     }
 
     game->assets = loadAssets();
+    game->bakedLevel = -1;
+    game->hoverCell = -1;
+    game->draggedBox = -1;
+    clearReach(&game->reach);
     return game;
 }
 
+static void freeChunks(Game* game) {
+    for (int i = 0; i < game->chunksX * game->chunksY; i++)
+        if (game->chunks[i].tiles.vertexCount > 0) UnloadMesh(game->chunks[i].tiles);
+    free(game->chunks);
+    game->chunks = NULL;
+    game->chunksX = game->chunksY = 0;
+}
+
 void cleanupGame(Game* game) {
+    freeSolution(&game->solution);
+    freeSolution(&game->plan);
+    freeJournal(&game->journal);
+    freeReach(&game->reach);
+    free(game->walk);
+    free(game->slides.cells);
+    for (int i = 0; i < NumModels; i++)
+        free(game->instances[i]);
+    freeChunks(game);
     cleanupAssets(game->assets);
-    for (int i = 0; i < NUM_LEVELS; i++) {
-        free(game->levels[i].pieces);
-        free(game->levels[i].original);
-    }
-    free(game->levels);
+    cleanupLevel(&game->current);
+    closePack(&game->pack);
 }
 
-void orientCamera(Game* game) {
-    float w = game->levels[game->level].width * game->assets->tileSize.x;
-    float h = game->levels[game->level].height * game->assets->tileSize.y;
+Level* currentLevel(Game* game) { return &game->current; }
+
+int numPlayableLevels(Game* game) {
+    return fmin(game->pack.numLevels, NUM_LEVELS);
+}
+
+// where the player is drawn, part of the way through the move they're making
+static Vector2 playerPosition(Game* game) {
+    return animationValue(
+        &game->animations, game->playerMove, game->player, game->tickAlpha);
+}
+
+// where the camera should look: the middle of the level, or the player when
+// the level doesn't fit on screen, without going further out than the edges
+static Vector3 cameraGoal(Game* game) {
+    float w = currentLevel(game)->width * game->assets->tileSize.x;
+    float h = currentLevel(game)->height * game->assets->tileSize.y;
     Vector3 center = {w / 2.0, 0, h / 2.0};
+    if (!game->followPlayer) return center;
 
-    // Camera distance needed to be to be able to fully see the longest side
-    float longerSide = fmax(w, h);
-    float distance = (longerSide / 2.0) / tanf((45 * DEG2RAD) / 2.0);
-    distance = fmax(45, fmin(distance, 80)); // shouldn't be too zoomed in or zoomed out
+    Vector2 player = playerPosition(game);
+    Vector3 goal = {
+        game->drawOffset.x + player.x * game->assets->tileSize.x, 0,
+        game->drawOffset.z + player.y * game->assets->tileSize.z
+    };
+
+    // roughly how much of the ground is in view around the target
+    float halfHeight = game->cameraDistance * tanf(game->camera.fovy * DEG2RAD / 2.0);
+    float aspect = GetScreenHeight() > 0 ? (float)GetScreenWidth() / GetScreenHeight() : 1;
+    float halfWidth = halfHeight * aspect;
+    goal.x = w > halfWidth * 2 ? Clamp(goal.x, halfWidth, w - halfWidth) : center.x;
+    goal.z = h > halfHeight * 2 ? Clamp(goal.z, halfHeight, h - halfHeight) : center.z;
+    return goal;
+}
 
+static void placeCamera(Game* game, Vector3 target) {
     // coordinates necessary to tilt the camera back (tilting the content forwards)
     float tilt = -28.0 * DEG2RAD;
-    float y = distance * cosf(tilt);
-    float z = distance * sinf(tilt);
+    float y = game->cameraDistance * cosf(tilt);
+    float z = game->cameraDistance * sinf(tilt);
+
+    game->camera.target = target;
+    game->camera.position = (Vector3){ target.x, y, target.z - z };
+}
+
+void orientCamera(Game* game) {
+    float w = currentLevel(game)->width * game->assets->tileSize.x;
+    float h = currentLevel(game)->height * game->assets->tileSize.y;
+
+    // Camera distance needed to be to be able to fully see the longest side
+    float longerSide = fmax(w, h);
+    float distance = (longerSide / 2.0) / tanf((45 * DEG2RAD) / 2.0);
+    game->followPlayer = distance > MAX_CAMERA_DISTANCE;
+    // shouldn't be too zoomed in or zoomed out
+    game->cameraDistance = fmax(MIN_CAMERA_DISTANCE, fmin(distance, MAX_CAMERA_DISTANCE));
 
     game->camera.fovy = 45;
-    game->camera.target = center;
-    game->camera.position = (Vector3){ center.x, y, center.z - z };
     game->camera.up = (Vector3){ 0.0f, 0.0f, -1.0f };
     game->camera.projection = CAMERA_PERSPECTIVE;
 
@@ -56,188 +127,599 @@ void orientCamera(Game* game) {
         game->assets->tileSize.x, 0.0,
         h > 50 ? -game->assets->tileSize.z / 2.0 : 0
     };
+    placeCamera(game, cameraGoal(game));
+}
+
+// ease the camera towards the player on levels it has to follow them through
+void updateCamera(Game* game) {
+    if (!game->followPlayer) return;
+    float t = 1 - expf(-game->frameTime * CAMERA_FOLLOW_SPEED); // the same at any frame rate
+    placeCamera(game, Vector3Lerp(game->camera.target, cameraGoal(game), t));
 }
 
 bool levelSolved(Game *game) {
-    Level* level = &game->levels[game->level];
-    return countCompletedGoals(level) == level->numGoals;
+    return isSolved(currentLevel(game));
+}
+
+void getFirstAndLastWalls(Level* level, int row, int* first, int* last) {
+    *first = level->width;
+    *last = 0;
+    for (int i = 0; i < level->width; i++) {
+        int index = row * level->width + i;
+        if (isWall(level, index)) {
+            if (i < *first) *first = i;
+            if (i > *last) *last = i;
+        }
+    }
+}
+
+void addInstance(Game* game, ModelType type, Vector3 offset, Vector2 pos, bool offsetHeight) {
+    Matrix transform = getModelTransform(game->assets, type, offset, pos, 0, offsetHeight);
+    game->instances[type][game->numInstances[type]++] = transform;
+}
+
+static BoundingBox transformBoundingBox(BoundingBox box, Matrix transform) {
+    BoundingBox result = { Vector3Transform(box.min, transform), Vector3Transform(box.min, transform) };
+    for (int i = 1; i < 8; i++) {
+        Vector3 corner = {
+            i & 1 ? box.max.x : box.min.x,
+            i & 2 ? box.max.y : box.min.y,
+            i & 4 ? box.max.z : box.min.z,
+        };
+        corner = Vector3Transform(corner, transform);
+        result.min = Vector3Min(result.min, corner);
+        result.max = Vector3Max(result.max, corner);
+    }
+    return result;
+}
+
+// merge the walls and the floor into a mesh per chunk. they never move, so
+// this happens once per level instead of every frame
+void bakeLevel(Game* game) {
+    if (game->bakedLevel == game->level) return; // restarting keeps the same tiles
+    game->bakedLevel = game->level;
+
+    Level* level = currentLevel(game);
+    freeChunks(game);
+    game->chunksX = (level->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    game->chunksY = (level->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    game->chunks = calloc(game->chunksX * game->chunksY, sizeof(Chunk));
+
+    int* first = malloc(level->height * sizeof(int));
+    int* last = malloc(level->height * sizeof(int));
+    for (int y = 0; y < level->height; y++)
+        getFirstAndLastWalls(level, y, &first[y], &last[y]);
+
+    // the boxes stand on the tiles, so the chunks have to be as tall as they are
+    Vector3 boxOffset = game->drawOffset;
+    boxOffset.y = 0.5;
+    BoundingBox box = transformBoundingBox(
+        GetModelBoundingBox(game->assets->assets[Crate].model),
+        getModelTransform(game->assets, Crate, boxOffset, (Vector2){ 0, 0 }, 0, true));
+
+    for (int cy = 0; cy < game->chunksY; cy++) {
+        for (int cx = 0; cx < game->chunksX; cx++) {
+            for (int i = 0; i < NumModels; i++) game->numInstances[i] = 0;
+
+            int endY = fmin((cy + 1) * CHUNK_SIZE, level->height);
+            for (int y = cy * CHUNK_SIZE; y < endY; y++) {
+                int startX = fmax(first[y], cx * CHUNK_SIZE);
+                int endX = fmin(last[y] + 1, (cx + 1) * CHUNK_SIZE);
+
+                for (int x = startX; x < endX; x++) { // inside the bordering walls
+                    int index = y * level->width + x;
+                    Vector2 pos = { x, y };
+
+                    // boxes and walls sit on top of a floor tile
+                    ModelType floor = isGoal(level, index) ? Goal : Floor;
+                    addInstance(game, floor, game->drawOffset, pos, false);
+
+                    if (isWall(level, index)) {
+                        Vector3 offset = game->drawOffset;
+                        offset.y = 1.0;
+                        addInstance(game, Wall, offset, pos, true);
+                    }
+                }
+            }
+
+            Chunk* chunk = &game->chunks[cy * game->chunksX + cx];
+            chunk->tiles = bakeModels(game->assets, game->instances, game->numInstances);
+            if (chunk->tiles.vertexCount == 0) continue;
+            chunk->bounds = GetMeshBoundingBox(chunk->tiles);
+            chunk->bounds.min.y = fmin(chunk->bounds.min.y, box.min.y);
+            chunk->bounds.max.y = fmax(chunk->bounds.max.y, box.max.y);
+        }
+    }
+
+    free(first);
+    free(last);
 }
 
 void changeLevel(Game* game, int levelIndex, bool advance) {
     if (advance) {
         levelIndex = game->level + 1;
-        updateSound(game->assets, SuccessSfx, true);
+        playSound(game->assets, SuccessSfx);
     }
 
-    game->level = fmax(0, fmin(levelIndex, NUM_LEVELS - 1));
-    orientCamera(game);
+    // a push that's still sliding or a move that's still queued
+    // belongs to the old level, it can't land on the new one
+    stopAnimation(&game->animations, game->slides.animation);
+    stopAnimation(&game->animations, game->playerMove);
+    stopAnimation(&game->animations, game->playerTurn);
+    game->slides.count = 0;
+    game->queueLength = 0;
+
+    game->level = fmax(0, fmin(levelIndex, numPlayableLevels(game) - 1));
+    cleanupLevel(&game->current);
+    if (loadPackedLevel(&game->pack, game->level, &game->current) == -1) {
+        printf("error loading level %d", game->level + 1);
+        exit(-1);
+    }
 
-    Level* level = &game->levels[game->level];
-    Vector2 pos = { level->playerStartX, level->playerStartY };
-    game->playerPosition = createAnimation(pos, false, PLAYER_SPEED);
-    game->playerRotation = createAnimation((Vector2){ 0, 0 }, true, PLAYER_SPEED);
+    Level* level = currentLevel(game);
+    game->player = (Vector2){ level->playerStartX, level->playerStartY };
+    game->playerAngle = 0;
+    orientCamera(game);
+    game->deadlocked = false;
+    clearJournal(&game->journal);
+
+    // a cell adds at most one instance of each model, and a
+    // line of boxes can't be longer than the level
+    for (int i = 0; i < NumModels; i++) {
+        size_t size = level->width * level->height * sizeof(Matrix);
+        game->instances[i] = realloc(game->instances[i], size);
+    }
+    int longestLine = fmax(level->width, level->height);
+    if (longestLine > game->slides.capacity) {
+        game->slides.cells = realloc(game->slides.cells, longestLine * sizeof(int));
+        game->slides.capacity = longestLine;
+    }
+    game->walk = realloc(game->walk, level->width * level->height);
+    clearReach(&game->reach); // the boxes can look the same on another level
+    game->hoverCell = -1;
+    bakeLevel(game);
 
     // show the solution for each level the player has already solved
-    if (game->assets->data.solvedLevels[game->level])
-        solveLevel(level);
+    stopSolution(game);
+    if (game->assets->data.solvedLevels[game->level]) {
+        restartLevel(level);
+        game->solution = solveLevel(
+            level, level->playerStartX, level->playerStartY, SOLVER_MEMORY_LIMIT);
+    }
 }
 
-void getFirstAndLastWalls(Level* level, int row, int* first, int* last) {
-    *first = level->width;
-    *last = 0;
-    for (int i = 0; i < level->width; i++) {
-        int index = row * level->width + i;
-        if (level->pieces[index].type == Border) {
-            if (i < *first) *first = i;
-            if (i > *last) *last = i;
+bool isMoving(Game* game) {
+    return isAnimationRunning(&game->animations, game->playerMove) ||
+           isAnimationRunning(&game->animations, game->playerTurn) ||
+           game->slides.count > 0;
+}
+
+bool isAnimating(Game* game) {
+    bool playingSolution =
+        game->solution.solved && game->solutionStep < game->solution.numMoves;
+    bool walking = game->walkStep < game->walkLength;
+    bool cameraMoving =
+        game->followPlayer && Vector3Distance(game->camera.target, cameraGoal(game)) > 0.01;
+    return isMoving(game) || game->queueLength > 0 || playingSolution || walking ||
+           cameraMoving;
+}
+
+// stops the walk to a clicked cell and the box being dragged too, the player took over
+void stopSolution(Game* game) {
+    freeSolution(&game->solution);
+    game->solutionStep = 0;
+    game->walkLength = 0;
+    game->walkStep = 0;
+    freeSolution(&game->plan);
+    game->draggedBox = -1;
+    game->dragTarget = -1;
+}
+
+// take the next step of a lurd string once the last one is done
+static void playMoves(Game* game, const char* moves, int length, int* step) {
+    if (*step >= length || isMoving(game)) return;
+
+    switch (tolower(moves[(*step)++])) {
+        case 'l': movePlayer(game, -1, 0); break;
+        case 'u': movePlayer(game, 0, -1); break;
+        case 'r': movePlayer(game, 1, 0); break;
+        case 'd': movePlayer(game, 0, 1); break;
+    }
+}
+
+// hold on to a move until the ones before it are done. when the queue is full
+// the player is far enough behind, so the newest keypress is the one dropped
+void queueMove(Game* game, int deltaX, int deltaY) {
+    if (game->queueLength == MOVE_QUEUE_SIZE) return;
+    char move = deltaX < 0 ? 'l' : deltaX > 0 ? 'r' : deltaY < 0 ? 'u' : 'd';
+    game->queuedMoves[(game->queueStart + game->queueLength++) % MOVE_QUEUE_SIZE] = move;
+}
+
+static void playQueuedMove(Game* game) {
+    if (game->queueLength == 0 || isMoving(game)) return;
+    int step = 0;
+    playMoves(game, &game->queuedMoves[game->queueStart], 1, &step);
+    game->queueStart = (game->queueStart + 1) % MOVE_QUEUE_SIZE;
+    game->queueLength--;
+}
+
+// the moves still waiting play faster, so the player catches up to the keys
+// within about MAX_MOVE_LAG instead of falling further behind
+static float moveDuration(Game* game) {
+    return fmin(PLAYER_SPEED, MAX_MOVE_LAG / (game->queueLength + 1));
+}
+
+// queued moves go first, anything started before they're done would be out of date
+static bool isBusy(Game* game) {
+    return isMoving(game) || game->queueLength > 0;
+}
+
+// walk the player through the next move of the solution
+void playSolution(Game* game) {
+    if (!game->solution.solved) return;
+    playMoves(game, game->solution.moves, game->solution.numMoves, &game->solutionStep);
+}
+
+static int playerCell(Game* game) {
+    return round(game->player.y) * currentLevel(game)->width + round(game->player.x);
+}
+
+// the floor tile of the top left cell, the others are shifted over from it
+static BoundingBox firstTile(Game* game) {
+    Model floor = game->assets->assets[Floor].model;
+    Matrix transform = getModelTransform(
+        game->assets, Floor, game->drawOffset, (Vector2){ 0, 0 }, 0, false);
+    return transformBoundingBox(GetModelBoundingBox(floor), transform);
+}
+
+// the cell whose floor is drawn under a point on the screen, -1 if there isn't one
+int cellAtScreen(Game* game, Vector2 point) {
+    Level* level = currentLevel(game);
+    BoundingBox tile = firstTile(game);
+    Ray ray = GetMouseRay(point, game->camera);
+    if (ray.direction.y >= 0) return -1;
+
+    float t = (tile.max.y - ray.position.y) / ray.direction.y;
+    int x = floorf((ray.position.x + ray.direction.x * t - tile.min.x) / game->assets->tileSize.x);
+    int y = floorf((ray.position.z + ray.direction.z * t - tile.min.z) / game->assets->tileSize.z);
+    if (x < 0 || y < 0 || x >= level->width || y >= level->height) return -1;
+    return y * level->width + x;
+}
+
+// walk the player along the shortest path to a cell, without pushing anything
+void walkTo(Game* game, int index) {
+    if (isBusy(game)) return;
+    updateReach(&game->reach, currentLevel(game), playerCell(game));
+    int length = findWalk(&game->reach, index, game->walk);
+    if (length <= 0) return;
+    game->walkLength = length;
+    game->walkStep = 0;
+}
+
+// a flat square lying on the floor of a cell
+static void drawMarker(Game* game, BoundingBox tile, int index, float size) {
+    int width = currentLevel(game)->width;
+    Vector3 p = {
+        (tile.min.x + tile.max.x) / 2 + (index % width) * game->assets->tileSize.x,
+        tile.max.y + 0.05,
+        (tile.min.z + tile.max.z) / 2 + (index / width) * game->assets->tileSize.z
+    };
+    DrawCube(p, size, 0.1, size, WHITE);
+}
+
+// small markers along the way to the cell under the mouse. the search is
+// cached, so this only follows the path back from that cell
+static void drawWalkPreview(Game* game) {
+    if (game->hoverCell == -1 || isMoving(game) || game->walkStep < game->walkLength)
+        return;
+    Level* level = currentLevel(game);
+    updateReach(&game->reach, level, playerCell(game));
+    if (!canReach(&game->reach, game->hoverCell)) return;
+
+    BoundingBox tile = firstTile(game);
+    int markers = 0;
+    for (int i = game->hoverCell; i != game->reach.start; i = game->reach.previous[i]) {
+        drawMarker(game, tile, i, 0.5);
+        markers++;
+    }
+    if (markers > 0) countDrawCall(markers * 12);
+}
+
+// start dragging the box on a cell, returns false if there isn't one
+bool startDrag(Game* game, int index) {
+    Level* level = currentLevel(game);
+    if (isBusy(game) || index < 0 || !isBox(level, index)) return false;
+    game->draggedBox = index;
+    game->dragTarget = -1;
+    return true;
+}
+
+// plan the pushes to the cell the box is being dragged over. it only runs
+// when that cell changes, and the planner answers well within a frame
+void dragBoxTo(Game* game, int index) {
+    if (game->draggedBox == -1 || index == game->dragTarget) return;
+    game->dragTarget = index;
+    freeSolution(&game->plan);
+    if (index != -1)
+        game->plan = planPush(currentLevel(game), playerCell(game), game->draggedBox, index);
+}
+
+// play the plan the same way a solution gets played
+void dropBox(Game* game) {
+    Solution plan = game->plan;
+    game->plan = (Solution){ 0 };
+    bool play = plan.solved && plan.numMoves > 0 && !isMoving(game);
+    stopSolution(game); // ends the drag
+    if (play) game->solution = plan;
+    else freeSolution(&plan);
+}
+
+// bigger markers on each cell the dragged box would get pushed through
+static void drawPlanPreview(Game* game) {
+    if (game->draggedBox == -1 || !game->plan.solved) return;
+    Level* level = currentLevel(game);
+    BoundingBox tile = firstTile(game);
+    int box = game->draggedBox;
+    for (int i = 0; i < game->plan.numMoves; i++) {
+        switch (game->plan.moves[i]) {
+            case 'L': box -= 1; break;
+            case 'U': box -= level->width; break;
+            case 'R': box += 1; break;
+            case 'D': box += level->width; break;
+            default: continue;
         }
+        drawMarker(game, tile, box, 1.2);
     }
+    if (game->plan.numPushes > 0) countDrawCall(game->plan.numPushes * 12);
 }
 
-ModelType getModelType(Piece p) {
-    if (p.type == Border) return Wall;
-    if (p.type == Box) return Crate;
-    return p.isGoal ? Goal : Floor;
+void playWalk(Game* game) {
+    playMoves(game, game->walk, game->walkLength, &game->walkStep);
 }
 
-void updateBoxAnimations(Game* game) {
-    Level* level = &game->levels[game->level];
-    bool allDone = true;
+bool isSliding(Game* game, int index) {
+    for (int i = 0; i < game->slides.count; i++)
+        if (game->slides.cells[i] == index) return true;
+    return false;
+}
 
-    for (int i = 0; i < game->numBoxMoves; i++) {
-        int index = game->boxMoves[i];
-        updateAnimation(&level->pieces[index].boxSlide, GetFrameTime());
-        if (level->pieces[index].boxSlide.active)
-            allDone = false;
+// once the boxes are done animating, actually move them to their
+// target position. the box at the front of the line was saved first,
+// so every box moves into a cell that's already been emptied
+static void landBoxes(void* data) {
+    Game* game = data;
+    BoxSlides* slides = &game->slides;
+    Level* level = currentLevel(game);
+    int step = slides->deltaY * level->width + slides->deltaX;
+    for (int i = 0; i < slides->count; i++)
+        moveBox(level, slides->cells[i], slides->cells[i] + step);
+
+    // a push can only add a deadlock around the boxes it moved. undoing
+    // can take one back, so then every box gets looked at
+    if (slides->pulled) {
+        game->deadlocked = hasDeadlock(level);
+    } else {
+        for (int i = 0; i < slides->count && !game->deadlocked; i++)
+            game->deadlocked = causesDeadlock(level, slides->cells[i] + step);
     }
+    slides->count = 0;
+}
 
-    if (!allDone || game->numBoxMoves == 0) return;
+// line up the boxes with slideBox, then slide them all one cell over
+static void slideBox(Game* game, int index) {
+    game->slides.cells[game->slides.count++] = index;
+}
 
-    // once all the boxes are done animating, actually
-    // move them to their target position
-    for (int i = 0; i < game->numBoxMoves; i++) {
-        int index = game->boxMoves[i];
-        Animation a = level->pieces[index].boxSlide;
+static void slideBoxes(Game* game, int deltaX, int deltaY, bool pulled) {
+    BoxSlides* slides = &game->slides;
+    if (slides->count == 0) return;
+    slides->deltaX = deltaX;
+    slides->deltaY = deltaY;
+    slides->pulled = pulled;
+    slides->animation = startAnimation(
+        &game->animations, (Vector2){ 0, 0 }, (Vector2){ 1, 0 }, moveDuration(game),
+        landBoxes, game);
+}
 
-        int currentIndex = a.vector.start.y * level->width + a.vector.start.x;
-        int targetIndex = a.vector.end.y * level->width + a.vector.end.x;
+// one step of the animations and the moves. boxes only land in their cell on
+// a tick, so a slow frame plays out as more ticks instead of a jump
+static void tickGame(Game* game, bool paused) {
+    updateAnimations(&game->animations, TICK_TIME);
+    if (paused) return;
+    playQueuedMove(game);
+    playSolution(game);
+    playWalk(game);
+}
+
+void advanceGame(Game* game, bool paused) {
+    game->tickTime = fmin(game->tickTime + game->frameTime, MAX_TICKS * TICK_TIME);
+    while (game->tickTime >= TICK_TIME) {
+        tickGame(game, paused);
+        game->tickTime -= TICK_TIME;
+    }
+    game->tickAlpha = game->tickTime / TICK_TIME;
+}
 
-        level->pieces[targetIndex].type = Box;
-        level->pieces[targetIndex].boxSlide =
-            createAnimation(a.vector.end, false, PLAYER_SPEED);
+// the planes around what the camera sees, facing inwards
+typedef struct {
+    Vector4 planes[6];
+} Frustum;
+
+// pulled out of the matrices BeginMode3D set up
+static Frustum getFrustum() {
+    Matrix m = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+    Vector4 rows[4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 },
+        { m.m3, m.m7, m.m11, m.m15 },
+    };
 
-        level->pieces[currentIndex].type = Empty;
-        level->pieces[currentIndex].boxSlide =
-            createAnimation(a.vector.start, false, PLAYER_SPEED);
+    Frustum frustum;
+    for (int i = 0; i < 3; i++) {
+        Vector4 r = rows[i], w = rows[3];
+        frustum.planes[i * 2] = (Vector4){ w.x + r.x, w.y + r.y, w.z + r.z, w.w + r.w };
+        frustum.planes[i * 2 + 1] = (Vector4){ w.x - r.x, w.y - r.y, w.z - r.z, w.w - r.w };
     }
+    return frustum;
+}
 
-    game->numBoxMoves = 0;
+// a box is outside when its corner furthest along a plane's normal is behind it
+static bool boxInFrustum(Frustum* frustum, BoundingBox box) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = frustum->planes[i];
+        float x = p.x > 0 ? box.max.x : box.min.x;
+        float y = p.y > 0 ? box.max.y : box.min.y;
+        float z = p.z > 0 ? box.max.z : box.min.z;
+        if (p.x * x + p.y * y + p.z * z + p.w < 0) return false;
+    }
+    return true;
 }
 
 void drawGame(Game* game) {
-    updateBoxAnimations(game);
-    Level* level = &game->levels[game->level];
+    Level* level = currentLevel(game);
+
+    // Draw the chunks of level tiles that are in view
+    Frustum frustum = getFrustum();
+    for (int i = 0; i < game->chunksX * game->chunksY; i++) {
+        Chunk* chunk = &game->chunks[i];
+        chunk->visible =
+            chunk->tiles.vertexCount > 0 && boxInFrustum(&frustum, chunk->bounds);
+        if (chunk->visible) drawBakedModels(game->assets, chunk->tiles);
+    }
 
-    // Draw the level tiles
-    for (int y = 0; y < level->height; y++) {
-        int first, last;
-        getFirstAndLastWalls(level, y, &first, &last);
+    drawWalkPreview(game);
+    drawPlanPreview(game);
 
-        for (int x = 0; x < level->width; x++) {
-            if (x < first || x > last) continue; // Not inside the bordering walls
+    // Draw the boxes that are resting
+    game->numInstances[Crate] = 0;
+    for (int w = 0; w < level->numWords; w++) {
+        for (uint64_t bits = level->boxes[w]; bits != 0; bits &= bits - 1) {
+            int index = w * 64 + __builtin_ctzll(bits);
+            if (isSliding(game, index)) continue; // drawn below
 
-            Piece p = level->pieces[y * level->width + x];
-            ModelType type = getModelType(p);
+            int x = index % level->width, y = index / level->width;
+            int chunk = (y / CHUNK_SIZE) * game->chunksX + x / CHUNK_SIZE;
+            if (!game->chunks[chunk].visible) continue;
             Vector2 pos = { x, y };
-            Vector2 realPos = p.type == Box ? p.boxSlide.vector.value : pos;
-
-            // Draw the floor beneath
-            if (p.type != Empty) {
-                ModelType t = p.isGoal ? Goal : Floor;
-                drawModel(game->assets, t, game->drawOffset, pos, 0, false);
-            }
-
-            // Wall, Floor, Goal, Crate, Guy, NumAssets,
             Vector3 offset = game->drawOffset;
-            if (p.type == Border) offset.y = 1.0;
-            else if (p.type != Empty) offset.y = 0.5;
-            drawModel(game->assets, type, offset, realPos, 0, p.type != Empty);
+            offset.y = 0.5;
+            addInstance(game, Crate, offset, pos, true);
         }
     }
+    drawModelInstances(
+        game->assets, Crate, game->instances[Crate], game->numInstances[Crate]);
+
+    // Draw the boxes that are sliding
+    BoxSlides* slides = &game->slides;
+    float slid = animationValue(
+        &game->animations, slides->animation, (Vector2){ 1, 0 }, game->tickAlpha).x;
+    for (int i = 0; i < slides->count; i++) {
+        Vector3 offset = game->drawOffset;
+        offset.y = 0.5;
+        Vector2 pos = {
+            slides->cells[i] % level->width + slides->deltaX * slid,
+            slides->cells[i] / level->width + slides->deltaY * slid,
+        };
+        drawModel(game->assets, Crate, offset, pos, 0, true);
+    }
 
     // Draw the player
+    Vector2 angle = { game->playerAngle, 0 };
     drawModel(
         game->assets,
         Guy,
         game->drawOffset,
-        game->playerPosition.vector.value,
-        game->playerRotation.scalar.value,
+        playerPosition(game),
+        animationValue(&game->animations, game->playerTurn, angle, game->tickAlpha).x,
         true
     );
-    updateAnimation(&game->playerPosition, GetFrameTime());
-    updateAnimation(&game->playerRotation, GetFrameTime());
 }
 
-bool pushBoxes(Game* game, Vector2 next, int x, int y) {
-    Level* level = &game->levels[game->level];
-
-    // get the position of the last box that'll be pushed
-    Vector2 end = next;
-    while (true) {
-        Piece p = level->pieces[(int)(end.y * level->width + end.x)];
-        if (p.type != Box) {
-            if (p.type == Border)
-                return false; // wall's in the way or the slide animation's running
-            break;
-        }
-        end.x += x;
-        end.y += y;
-    }
-
-    // start the box sliding animation
-    Vector2 pos = { end.x - x, end.y - y };
-    while (pos.x != next.x - x || pos.y != next.y - y) {
-        int current = pos.y * level->width + pos.x;
-        Vector2 after = { pos.x + x, pos.y + y };
+void pushBoxes(Game* game, Move move, int x, int y) {
+    Level* level = currentLevel(game);
+    int step = y * level->width + x;
 
-        // save the index of each box that's animating in order
-        game->boxMoves[game->numBoxMoves++] = current;
-        startAnimation(&level->pieces[current].boxSlide, after, false);
+    // slide the boxes from the front of the line
+    for (int current = move.end - step; current != move.next - step; current -= step)
+        slideBox(game, current);
+    slideBoxes(game, x, y, false);
 
-        pos.x -= x;
-        pos.y -= y;
-    }
+    playSound(game->assets, PushSfx);
+}
 
-    updateSound(game->assets, MoveSfx, true);
-    return true;
+// turn the player and start animating the move, the level changes once the boxes stop
+Move startMove(Game* game, int deltaX, int deltaY) {
+    float duration = moveDuration(game);
+    float angle = deltaX == 1 ? 90 : deltaX == -1 ? 270 : deltaY == 1 ? 0 : 180;
+    game->playerTurn = startAnimation(
+        &game->animations, (Vector2){ game->playerAngle, 0 }, (Vector2){ angle, 0 },
+        duration, NULL, NULL);
+    game->playerAngle = angle;
+
+    Level* level = currentLevel(game);
+    int player = playerCell(game);
+
+    // the rules decide where everything goes, this just animates it
+    Move move = findMove(level, player, deltaX, deltaY);
+    if (!move.possible) return move;
+    if (move.end != -1) pushBoxes(game, move, deltaX, deltaY);
+    else playSound(game->assets, MoveSfx);
+
+    Vector2 next = { move.next % level->width, move.next / level->width };
+    game->playerMove =
+        startAnimation(&game->animations, game->player, next, duration, NULL, NULL);
+    game->player = next;
+    return move;
 }
 
 void movePlayer(Game* game, int deltaX, int deltaY) {
     // lock the player until animations are done running
-    if (game->playerRotation.active || game->playerPosition.active ||
-        game->numBoxMoves > 0) return;
+    if (isMoving(game)) return;
 
-    if (deltaX == 1)
-        startAnimation(&game->playerRotation, (Vector2){90, 0}, false);
-    if (deltaX == -1)
-        startAnimation(&game->playerRotation, (Vector2){270, 0}, false);
-    if (deltaY == 1)
-        startAnimation(&game->playerRotation, (Vector2){0, 0}, false);
-    if (deltaY == -1)
-        startAnimation(&game->playerRotation, (Vector2){180, 0}, false);
+    Level* level = currentLevel(game);
+    Move move = startMove(game, deltaX, deltaY);
+    if (!move.possible) return;
 
-    Vector2 current = game->playerPosition.vector.value;
-    Vector2 next =
-        (Vector2){round(current.x + deltaX), round(current.y + deltaY)};
+    int pushed = countPushed(level, move, deltaX, deltaY);
+    if (recordMove(&game->journal, deltaX, deltaY, pushed) == -1)
+        clearJournal(&game->journal); // the history no longer matches the level
+}
 
-    Level* level = &game->levels[game->level];
-    int index = next.y * level->width + next.x;
-    if (level->pieces[index].type == Border) return;
+// walk the player back a cell, pulling the boxes they pushed along with them
+void undoMove(Game* game) {
+    int deltaX, deltaY, pushed;
+    if (isBusy(game) || !undoStep(&game->journal, &deltaX, &deltaY, &pushed))
+        return;
+    float duration = moveDuration(game);
+
+    Level* level = currentLevel(game);
+    int player = playerCell(game);
+    int step = deltaY * level->width + deltaX;
+
+    // the box nearest the player moves first, into the cell they're leaving
+    for (int i = 1; i <= pushed; i++)
+        slideBox(game, player + step * i);
+    slideBoxes(game, -deltaX, -deltaY, true);
+    playSound(game->assets, pushed > 0 ? PushSfx : MoveSfx);
+
+    // facing the same way, so they step backwards
+    Vector2 previous = { game->player.x - deltaX, game->player.y - deltaY };
+    game->playerMove =
+        startAnimation(&game->animations, game->player, previous, duration, NULL, NULL);
+    game->player = previous;
+}
 
-    if (level->pieces[index].type == Box) {
-        bool canPushBoxes = pushBoxes(game, next, deltaX, deltaY);
-        if (!canPushBoxes) return;
-    }
+// put the moves made so far on the clipboard as a lurd string
+void copyMoves(Game* game) {
+    char* moves = malloc(game->journal.position + 1);
+    writeLurd(&game->journal, moves);
+    SetClipboardText(moves);
+    free(moves);
+}
 
-    startAnimation(&game->playerPosition, next, false);
+void redoMove(Game* game) {
+    int deltaX, deltaY;
+    if (isBusy(game) || !redoStep(&game->journal, &deltaX, &deltaY)) return;
+    startMove(game, deltaX, deltaY);
 }
@@ -1,30 +1,111 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include "animation.h"
 #include "assets.h"
+#include "pack.h"
+#include "solver.h"
+
+#define MOVE_QUEUE_SIZE 8 // keypresses held on to while the player is moving
+#define MAX_MOVE_LAG 0.4 // seconds a move can take to start playing, roughly
+#define TICK_TIME (1.0 / 120) // seconds the game moves forward by each tick
+#define MAX_TICKS 12 // per frame, a longer hitch slows the game down instead of skipping ahead
+
+// a square of the level's tiles, merged into one mesh and
+// skipped when it's outside the camera's view
+typedef struct {
+    Mesh tiles;
+    BoundingBox bounds; // includes the boxes resting on the tiles
+    bool visible; // as of the last frame drawn
+} Chunk;
+
+// the boxes moving along with the player. they all slide the same
+// way at the same time, so one animation is shared by the whole line
+typedef struct {
+    int animation; // goes from 0 to 1, the boxes land when it's done
+    int deltaX, deltaY;
+    bool pulled; // undone, which can take a deadlock back
+    int count;
+    int capacity; // only grows, a level never shrinks it under a pending slide
+    int* cells; // the cells the boxes are leaving, in the order they land
+} BoxSlides;
 
 typedef struct {
     Camera3D camera;
+    float cameraDistance;
+    bool followPlayer; // the level doesn't fit on screen
     Shader shader;
     AssetManager* assets;
 
-    Animation playerPosition;
-    Animation playerRotation;
+    // the game runs on a fixed tick, however often the frames get drawn
+    float frameTime; // seconds since the last frame, the camera eases by this
+    double tickTime; // time that hasn't been ticked yet
+    float tickAlpha; // how far the frame is between the last two ticks
+    AnimationPool animations; // everything that's moving, the app's fade too
+    Vector2 player; // where the player is headed, or standing
+    float playerAngle;
+    int playerMove; // animations in the pool, 0 when there's none
+    int playerTurn;
 
     int level;
-    Level* levels;
+    LevelPack pack; // only the first NUM_LEVELS are playable, that's what the save holds
+    Level current; // decoded from the pack when the level changes
     Vector3 drawOffset;
-    int numBoxMoves;
-    int boxMoves[25];
+    BoxSlides slides;
+    bool deadlocked; // a box got stuck somewhere it can't be solved from
+
+    // tile transforms, drawn with one call per model
+    Matrix* instances[NumModels];
+    int numInstances[NumModels];
+    // walls and floor never move, so they're merged when the level loads
+    Chunk* chunks;
+    int chunksX, chunksY;
+    int bakedLevel;
+
+    // lurd letters of the moves that came in while the player was moving, oldest first
+    char queuedMoves[MOVE_QUEUE_SIZE];
+    int queueStart;
+    int queueLength;
+
+    Journal journal; // the moves made on this level, for undo and redo
+
+    Solution solution; // played back on levels that were already solved
+    int solutionStep;
+
+    Reach reach; // where the player can walk to without pushing anything
+    char* walk; // lurd letters of the walk to the cell that was clicked
+    int walkLength;
+    int walkStep;
+    int hoverCell; // the path to this cell is shown, -1 for none
+
+    // dragging a box onto a cell plans the pushes that take it there
+    int draggedBox; // -1 when there's no drag going on
+    int dragTarget;
+    Solution plan;
 } Game;
 
 Game* createGame();
 void cleanupGame(Game* game);
+void updateCamera(Game* game);
+void advanceGame(Game* game, bool paused); // paused only runs the animations
 void drawGame(Game* game);
 
+Level* currentLevel(Game* game);
+int numPlayableLevels(Game* game);
 void changeLevel(Game* game, int levelIndex, bool advance);
 bool levelSolved(Game* game);
 
 void movePlayer(Game* game, int deltaX, int deltaY);
+void queueMove(Game* game, int deltaX, int deltaY);
+void undoMove(Game* game);
+void redoMove(Game* game);
+void copyMoves(Game* game);
+void stopSolution(Game* game);
+int cellAtScreen(Game* game, Vector2 point);
+void walkTo(Game* game, int index);
+bool startDrag(Game* game, int index);
+void dragBoxTo(Game* game, int index);
+void dropBox(Game* game);
+bool isAnimating(Game* game);
 
 #endif
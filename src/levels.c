@@ -1,4 +1,4 @@
-#include <raymath.h>
+#include <ctype.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -6,123 +6,566 @@
 
 #include "levels.h"
 
-typedef struct { int length; char* str; } Line;
+static void setBit(uint64_t* board, int index) {
+    board[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+
+// the cell next to index in direction d (left, up, right, down), -1 for walls
+static int neighbour(Level* level, int index, int d) {
+    static const int dx[4] = { -1, 0, 1, 0 };
+    static const int dy[4] = { 0, -1, 0, 1 };
+    int x = index % level->width + dx[d];
+    int y = index / level->width + dy[d];
+    if (x < 0 || y < 0 || x >= level->width || y >= level->height) return -1;
+    int next = y * level->width + x;
+    return isWall(level, next) ? -1 : next;
+}
+
+// a box can only reach a goal from the cells it could be pulled to from that
+// goal, since pulling needs the same two free cells a push does. every floor
+// cell that can't be pulled to from any goal is a dead square
+static void findDeadSquares(Level* level) {
+    static const int dx[4] = { -1, 0, 1, 0 };
+    static const int dy[4] = { 0, -1, 0, 1 };
+    int width = level->width, height = level->height;
+    int size = width * height;
+    uint64_t* alive = calloc(level->numWords, sizeof(uint64_t));
+    int* queue = malloc(size * sizeof(int));
+
+    for (int w = 0; w < level->numWords; w++) {
+        for (uint64_t bits = level->goals[w]; bits != 0; bits &= bits - 1) {
+            int goal = w * 64 + __builtin_ctzll(bits);
+            if (getBit(alive, goal)) continue;
+            int head = 0, tail = 0;
+            setBit(alive, goal);
+            queue[tail++] = goal;
+
+            while (head < tail) {
+                int cell = queue[head++];
+                int x = cell % width, y = cell / width;
+                for (int d = 0; d < 4; d++) {
+                    // the player stands two cells away to pull the box one cell over
+                    int playerX = x + 2 * dx[d], playerY = y + 2 * dy[d];
+                    if (playerX < 0 || playerY < 0 || playerX >= width || playerY >= height)
+                        continue;
+                    int box = cell + dy[d] * width + dx[d];
+                    int player = box + dy[d] * width + dx[d];
+                    if (getBit(alive, box) || isWall(level, box) || isWall(level, player))
+                        continue;
+                    setBit(alive, box);
+                    queue[tail++] = box;
+                }
+            }
+        }
+    }
+
+    for (int w = 0; w < level->numWords; w++)
+        level->deadSquares[w] = ~(level->walls[w] | alive[w]);
+    if (size % 64 != 0) // past the last cell
+        level->deadSquares[level->numWords - 1] &= ((uint64_t)1 << (size % 64)) - 1;
+    free(alive);
+    free(queue);
+}
+
+// boxes on goals, found by counting the bits both boards share
+static int countBoxesOnGoals(Level* level) {
+    int count = 0;
+    for (int i = 0; i < level->numWords; i++)
+        count += __builtin_popcountll(level->boxes[i] & level->goals[i]);
+    return count;
+}
+
+// make room for needed items, doubling the capacity so appends stay cheap
+static void* reserve(void* data, size_t* capacity, size_t needed, size_t itemSize) {
+    if (needed <= *capacity) return data;
+    size_t capacity2 = *capacity ? *capacity : 64;
+    while (capacity2 < needed) capacity2 *= 2;
+    data = realloc(data, capacity2 * itemSize);
+    if (data != NULL) *capacity = capacity2;
+    return data;
+}
+
+// the rows of the level being read, expanded and stored one after another
+typedef struct {
+    char* cells;
+    size_t numCells, cellCapacity;
+    int* rowLengths;
+    size_t numRows, rowCapacity;
+} Rows;
+
+typedef struct {
+    Collection* collection;
+    size_t levelCapacity;
+    size_t numBoardWords, boardCapacity;
+    Rows rows;
+} Parser;
+
+static bool addCells(Rows* rows, const char* cells, size_t count) {
+    rows->cells = reserve(rows->cells, &rows->cellCapacity, rows->numCells + count, 1);
+    if (rows->cells == NULL) return false;
+    memcpy(rows->cells + rows->numCells, cells, count);
+    rows->numCells += count;
+    return true;
+}
+
+static bool endRow(Rows* rows, size_t rowStart) {
+    rows->rowLengths = reserve(rows->rowLengths, &rows->rowCapacity, rows->numRows + 1, sizeof(int));
+    if (rows->rowLengths == NULL) return false;
+    rows->rowLengths[rows->numRows++] = rows->numCells - rowStart;
+    return true;
+}
 
-Piece getPiece(Line* lines, int width, int height, int x, int y) {
-    Piece p = { Empty, false };
-    if (x >= lines[y].length) return p;
-    char c = lines[y].str[x];
+// rows only hold board characters, digits for run length encoding and
+// '|' between encoded rows. anything else is a title or a comment
+static bool isRow(const char* line, size_t length) {
+    return length > 0 && strspn(line, "#@+$*.-_ |0123456789") == length &&
+           memchr(line, '#', length) != NULL;
+}
+
+// "3#" is the same as "###". '-' and '_' are floor like ' ', which
+// is anything that isn't a wall, box, goal or player
+static bool addRows(Rows* rows, const char* line, size_t length) {
+    size_t rowStart = rows->numCells;
+    for (size_t i = 0; i < length;) {
+        // most rows aren't encoded, so copy everything up to the next count
+        size_t plain = strcspn(line + i, "0123456789|");
+        if (plain > length - i) plain = length - i;
+        if (!addCells(rows, line + i, plain)) return false;
+        i += plain;
+        if (i == length) break;
+
+        if (line[i] == '|') {
+            if (!endRow(rows, rowStart)) return false;
+            rowStart = rows->numCells;
+            i++;
+            continue;
+        }
 
-    if (c == '$' || c == '*') {
-        p = (Piece){ Box, c == '*' };
-        p.boxSlide = createAnimation((Vector2){x, y}, false, PLAYER_SPEED);
+        int count = 0;
+        while (i < length && isdigit((unsigned char)line[i]))
+            count = count * 10 + line[i++] - '0';
+        if (i == length || line[i] == '|') continue; // a count with nothing after it
+        for (; count > 0; count--)
+            if (!addCells(rows, &line[i], 1)) return false;
+        i++;
     }
-    if (c == '.') p = (Piece){ Empty, true };
-    if (c == '#') p = (Piece){ Border, false };
-    return p;
+    return endRow(rows, rowStart);
 }
 
-Level parseLevel(Line* lines, int width, int height) {
+// turn the rows read so far into a level, with its boards at the end of the arena
+static bool addLevel(Parser* p) {
+    Collection* c = p->collection;
+    Rows* rows = &p->rows;
+    int width = 0, height = rows->numRows;
+    for (int y = 0; y < height; y++)
+        if (rows->rowLengths[y] > width) width = rows->rowLengths[y];
+    width++; // an empty column on the right, the camera is centered with it in mind
+
+    c->levels = reserve(c->levels, &p->levelCapacity, c->numLevels + 1, sizeof(Level));
+    int numWords = (width * height + 63) / 64;
+    size_t offset = p->numBoardWords;
+    p->numBoardWords += 5 * numWords;
+    c->boards = reserve(c->boards, &p->boardCapacity, p->numBoardWords, sizeof(uint64_t));
+    if (c->levels == NULL || c->boards == NULL) return false;
+
+    uint64_t* boards = c->boards + offset;
+    memset(boards, 0, 5 * numWords * sizeof(uint64_t));
     Level level = {
         .numGoals = 0,
         .width = width, .height = height,
-        .pieces = calloc(width * height, sizeof(Piece)),
-        .original = calloc(width * height, sizeof(Piece)),
+        .numWords = numWords,
+        .walls = boards,
+        .goals = boards + numWords,
+        .boxes = boards + 2 * numWords,
+        .originalBoxes = boards + 3 * numWords,
+        .deadSquares = boards + 4 * numWords,
     };
 
+    // some levels have a stray '+' next to their '@'. it's plain floor
+    // there, counting it as a goal leaves more goals than boxes
+    bool hasPlayer = memchr(rows->cells, '@', rows->numCells) != NULL;
+    const char* cell = rows->cells;
     for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
+        for (int x = 0; x < rows->rowLengths[y]; x++, cell++) {
             int index = y * width + x;
-            Piece p = getPiece(lines, width, height, x, y);
-            level.original[index] = p;
-            level.pieces[index] = p;
-
-            if (p.isGoal)
-                level.goalIndexes[level.numGoals++] = index;
-
-            if (x < lines[y].length && lines[y].str[x] == '@') {
-                level.playerStartX = x;
-                level.playerStartY = y;
+            switch (*cell) {
+                case '#': setBit(level.walls, index); break;
+                case '$': setBit(level.originalBoxes, index); break;
+                case '*':
+                    setBit(level.originalBoxes, index);
+                    setBit(level.goals, index);
+                    level.numGoals++;
+                    break;
+                case '.':
+                    setBit(level.goals, index);
+                    level.numGoals++;
+                    break;
+                case '+': // the player standing on a goal
+                    if (hasPlayer) break;
+                    setBit(level.goals, index);
+                    level.numGoals++;
+                    level.playerStartX = x;
+                    level.playerStartY = y;
+                    break;
+                case '@':
+                    level.playerStartX = x;
+                    level.playerStartY = y;
+                    break;
             }
         }
     }
 
-    return level;
+    findDeadSquares(&level);
+    restartLevel(&level);
+    c->levels[c->numLevels++] = level;
+    rows->numCells = rows->numRows = 0;
+    return true;
+}
+
+// the arena moves as it grows, so the boards are pointed at once it's done
+static void placeBoards(Collection* c) {
+    uint64_t* boards = c->boards;
+    for (int i = 0; i < c->numLevels; i++) {
+        Level* level = &c->levels[i];
+        level->walls = boards;
+        level->goals = boards + level->numWords;
+        level->boxes = boards + 2 * level->numWords;
+        level->originalBoxes = boards + 3 * level->numWords;
+        level->deadSquares = boards + 4 * level->numWords;
+        boards += 5 * level->numWords;
+    }
+}
+
+// read a whole line no matter how long, without the line ending
+static bool readLine(FILE* file, char** line, size_t* capacity, size_t* length) {
+    *length = 0;
+    while (true) {
+        *line = reserve(*line, capacity, *length + 256, 1);
+        if (*line == NULL || fgets(*line + *length, *capacity - *length, file) == NULL)
+            break;
+        *length += strlen(*line + *length);
+        if ((*line)[*length - 1] == '\n') break;
+    }
+    while (*length > 0 && ((*line)[*length - 1] == '\n' || (*line)[*length - 1] == '\r'))
+        (*length)--;
+    return *line != NULL && (*length > 0 || !feof(file));
 }
 
-int parseLevels(char* filePath, Level* levels) {
+// read every level in the file a line at a time. levels end at the first line
+// that isn't a row, so blank lines, titles and comments all separate them.
+// returns the number of levels or -1 if the file can't be read
+int loadCollection(char* filePath, Collection* collection) {
+    *collection = (Collection){ 0 };
     FILE* file = fopen(filePath, "r");
     if (file == NULL) return -1;
 
-    int width = 0;
-    int height = 0;
-    Line lines[40];
+    Parser p = { .collection = collection };
+    char* line = NULL;
+    size_t capacity = 0, length;
+    bool ok = true;
 
-    int i = 0;
-    char line[100];
+    while (ok && readLine(file, &line, &capacity, &length)) {
+        if (isRow(line, length)) ok = addRows(&p.rows, line, length);
+        else if (p.rows.numRows > 0) ok = addLevel(&p);
+    }
+    if (ok && p.rows.numRows > 0) ok = addLevel(&p);
+    ok &= !ferror(file);
 
-    while (fgets(line, sizeof(line), file)) {
-        size_t length = strlen(line);
+    fclose(file);
+    free(line);
+    free(p.rows.cells);
+    free(p.rows.rowLengths);
+    if (!ok) {
+        freeCollection(collection);
+        return -1;
+    }
+    placeBoards(collection);
+    return collection->numLevels;
+}
 
-        if (length == 1 && line[0] == '\n') { // puzzles are separated by a new line
-            levels[i++] = parseLevel(lines, width, height);
+void freeCollection(Collection* collection) {
+    free(collection->levels);
+    free(collection->boards);
+    *collection = (Collection){ 0 };
+}
 
-            // reset
-            for (int y = 0; y < height; y++) {
-                free(lines[y].str);
-            }
-            width = height = 0;
-        } else {
-            width = length > width ? length : width; // lines can be of different lengths
-            lines[height++] = (Line){ length, strdup(line) };
+void restartLevel(Level* level) {
+    memcpy(level->boxes, level->originalBoxes, level->numWords * sizeof(uint64_t));
+    level->completedGoals = countBoxesOnGoals(level);
+    level->spareBoxes = -level->numGoals;
+    for (int i = 0; i < level->numWords; i++)
+        level->spareBoxes += __builtin_popcountll(level->boxes[i]);
+    level->boxVersion++;
+}
+
+void moveBox(Level* level, int from, int to) {
+    level->completedGoals += isGoal(level, to) - isGoal(level, from);
+    level->boxes[from >> 6] &= ~((uint64_t)1 << (from & 63));
+    setBit(level->boxes, to);
+    level->boxVersion++;
+}
+
+int countCompletedGoals(Level* level) {
+    return level->completedGoals;
+}
+
+bool isSolved(Level* level) {
+    return level->completedGoals == level->numGoals;
+}
+
+// the cell (deltaX, deltaY) away from index, -1 when that's off the level
+static int offsetCell(Level* level, int index, int deltaX, int deltaY) {
+    int x = index % level->width + deltaX;
+    int y = index / level->width + deltaY;
+    if (x < 0 || y < 0 || x >= level->width || y >= level->height) return -1;
+    return y * level->width + x;
+}
+
+Move findMove(Level* level, int player, int deltaX, int deltaY) {
+    Move move = { false, offsetCell(level, player, deltaX, deltaY), -1 };
+    if (move.next == -1 || isWall(level, move.next)) return move;
+
+    // the whole line of boxes in front of the player gets pushed
+    if (isBox(level, move.next)) {
+        move.end = move.next;
+        while (move.end != -1 && isBox(level, move.end))
+            move.end = offsetCell(level, move.end, deltaX, deltaY);
+        if (move.end == -1 || isWall(level, move.end)) return move;
+    }
+
+    move.possible = true;
+    return move;
+}
+
+void applyMove(Level* level, Move move) {
+    // pushing a line of boxes is the same as taking the
+    // first box away and adding one after the last
+    if (move.possible && move.end != -1) moveBox(level, move.next, move.end);
+}
+
+// move the player instantly, returns false if they're blocked
+bool makeMove(Level* level, int* player, int deltaX, int deltaY) {
+    Move move = findMove(level, *player, deltaX, deltaY);
+    if (!move.possible) return false;
+    applyMove(level, move);
+    *player = move.next;
+    return true;
+}
+
+// pushing moves the whole line of boxes in front of the player, so a box is
+// only stuck along an axis (0 for left and right, 1 for up and down) when one
+// side is a wall, maybe behind a line of boxes stuck along the other axis, or
+// when both sides are dead squares. boxes already being checked are assumed free.
+// a spare box can be pushed onto a dead square, so the last rule needs every box
+static bool blockedAlongAxis(Level* level, int index, int axis, int* checking, int depth) {
+    for (int i = 0; i < depth; i++)
+        if (checking[i] == index) return false;
+    if (depth == MAX_FREEZE_DEPTH) return false;
+
+    int a = neighbour(level, index, axis);
+    int b = neighbour(level, index, axis + 2);
+    if (level->spareBoxes == 0 && a != -1 && b != -1 && !isBox(level, a) &&
+        !isBox(level, b) && isDead(level, a) && isDead(level, b))
+        return true;
+
+    checking[depth] = index;
+    for (int side = axis; side < 4; side += 2) {
+        int next = neighbour(level, index, side);
+        while (next != -1 && isBox(level, next) &&
+               blockedAlongAxis(level, next, 1 - axis, checking, depth + 1))
+            next = neighbour(level, next, side);
+        if (next == -1) return true;
+    }
+    return false;
+}
+
+static bool isFrozen(Level* level, int index) {
+    int checking[MAX_FREEZE_DEPTH];
+    return blockedAlongAxis(level, index, 0, checking, 0) &&
+           blockedAlongAxis(level, index, 1, checking, 0);
+}
+
+// a box that can't be moved to a goal anymore
+static bool isStuck(Level* level, int index) {
+    return isDead(level, index) || (!isGoal(level, index) && isFrozen(level, index));
+}
+
+// a box that was just pushed onto index can't be moved to a goal anymore,
+// or it froze itself or one of the boxes next to it off of a goal
+bool causesDeadlock(Level* level, int index) {
+    // spare boxes can get stuck, it's how many of them are that matters
+    if (level->spareBoxes > 0) return hasDeadlock(level);
+    if (isDead(level, index)) return true;
+    if (!isGoal(level, index) && isFrozen(level, index)) return true;
+    for (int d = 0; d < 4; d++) {
+        int next = neighbour(level, index, d);
+        if (next != -1 && isBox(level, next) && !isGoal(level, next) &&
+            isFrozen(level, next))
+            return true;
+    }
+    return false;
+}
+
+// every box that's stuck, not just the ones next to the last push
+bool hasDeadlock(Level* level) {
+    int stuck = 0;
+    for (int w = 0; w < level->numWords; w++) {
+        for (uint64_t bits = level->boxes[w]; bits != 0; bits &= bits - 1) {
+            int index = w * 64 + __builtin_ctzll(bits);
+            if (isStuck(level, index) && ++stuck > level->spareBoxes) return true;
         }
     }
+    return false;
+}
 
-    // parse the last level
-    levels[i++] = parseLevel(lines, width, height);
-    for (int y = 0; y < height; y++) {
-        free(lines[y].str);
+static const int journalDeltaX[4] = { -1, 0, 1, 0 };
+static const int journalDeltaY[4] = { 0, -1, 0, 1 };
+static const char lurd[] = "lurd";
+
+// the number of boxes in the line the move pushes
+int countPushed(Level* level, Move move, int deltaX, int deltaY) {
+    if (move.end == -1) return 0;
+    return abs(move.end - move.next) / abs(deltaY * level->width + deltaX);
+}
+
+// forgets the moves that could be redone, returns -1 if the move can't be stored
+int recordMove(Journal* journal, int deltaX, int deltaY, int pushed) {
+    int direction = -1;
+    for (int d = 0; d < 4; d++)
+        if (journalDeltaX[d] == deltaX && journalDeltaY[d] == deltaY) direction = d;
+    if (direction == -1 || pushed > MAX_JOURNAL_PUSH) return -1;
+
+    if (journal->position == journal->capacity) {
+        int capacity = journal->capacity ? journal->capacity * 2 : 256;
+        uint8_t* moves = realloc(journal->moves, capacity);
+        if (moves == NULL) return -1;
+        journal->moves = moves;
+        journal->capacity = capacity;
     }
 
-    fclose(file);
-    return i != NUM_LEVELS ? -1 : 0;
+    journal->moves[journal->position++] = direction | pushed << 2;
+    journal->length = journal->position;
+    return 0;
 }
 
-void restartLevel(Level* level) {
-    int size = level->width * level->height * sizeof(Piece);
-    memcpy(level->pieces, level->original, size);
+// the last move, the caller walks it backwards
+bool undoStep(Journal* journal, int* deltaX, int* deltaY, int* pushed) {
+    if (journal->position == 0) return false;
+    uint8_t move = journal->moves[--journal->position];
+    *deltaX = journalDeltaX[move & 3];
+    *deltaY = journalDeltaY[move & 3];
+    *pushed = move >> 2;
+    return true;
 }
 
-// return true if all the goal positions are covered by a box
-int countCompletedGoals(Level* level) {
-    int completed = 0;
-    for (int i = 0; i < level->numGoals; i++) {
-        int pos = level->goalIndexes[i];
-        Piece p = level->pieces[pos];
-        if (p.isGoal && p.type == Box)
-            completed++;
-    }
-    return completed;
-}
-
-void solveLevel(Level* level) {
-    int nextGoal = 0;
-    for (int y = 0; y < level->height; y++) {
-        for (int x = 0; x < level->width; x++) {
-            int index = y * level->width + x;
-            Piece p = level->pieces[index];
-
-            // Move box into the next available goal position
-            if (!p.isGoal && p.type == Box) {
-                int goalIndex = level->goalIndexes[nextGoal++];
-                int goalX = goalIndex % level->width;
-                int goalY = (goalIndex - goalX) / level->width;
-
-                level->pieces[goalIndex].type = Box;
-                level->pieces[goalIndex].boxSlide =
-                    createAnimation((Vector2){ goalX, goalY }, false, PLAYER_SPEED);
-                level->pieces[index].type = Empty;
-            }
+// the move that was last undone, the caller makes it again
+bool redoStep(Journal* journal, int* deltaX, int* deltaY) {
+    if (journal->position == journal->length) return false;
+    uint8_t move = journal->moves[journal->position++];
+    *deltaX = journalDeltaX[move & 3];
+    *deltaY = journalDeltaY[move & 3];
+    return true;
+}
+
+void clearJournal(Journal* journal) {
+    journal->length = 0;
+    journal->position = 0;
+}
+
+void freeJournal(Journal* journal) {
+    free(journal->moves);
+    *journal = (Journal){ 0 };
+}
+
+// the moves up to the current position, out needs room for position + 1 characters
+int writeLurd(Journal* journal, char* out) {
+    for (int i = 0; i < journal->position; i++) {
+        uint8_t move = journal->moves[i];
+        char c = lurd[move & 3];
+        out[i] = (move >> 2) > 0 ? toupper(c) : c;
+    }
+    out[journal->position] = '\0';
+    return journal->position;
+}
+
+// play the moves from the start of the level and check that it ends up solved.
+// whitespace is skipped and the case is ignored, the pushes follow from the moves
+bool replayLurd(Level* level, const char* moves, int length, int* numMoves, int* numPushes) {
+    restartLevel(level);
+    int player = level->playerStartY * level->width + level->playerStartX;
+    *numMoves = 0;
+    *numPushes = 0;
+
+    for (int i = 0; i < length; i++) {
+        if (isspace((unsigned char)moves[i])) continue;
+        const char* c = strchr(lurd, tolower((unsigned char)moves[i]));
+        if (c == NULL || *c == '\0') return false;
+
+        int d = c - lurd;
+        Move move = findMove(level, player, journalDeltaX[d], journalDeltaY[d]);
+        if (!move.possible) return false;
+        applyMove(level, move);
+        player = move.next;
+        *numMoves += 1;
+        *numPushes += move.end != -1;
+    }
+    return isSolved(level);
+}
+
+// breadth first from the player, boxes are in the way like walls are
+void updateReach(Reach* reach, Level* level, int player) {
+    if (reach->start == player && reach->boxVersion == level->boxVersion) return;
+    int cells = level->width * level->height;
+    if (cells > reach->capacity) {
+        reach->previous = realloc(reach->previous, cells * sizeof(int));
+        reach->queue = realloc(reach->queue, cells * sizeof(int));
+        reach->capacity = cells;
+    }
+    for (int i = 0; i < cells; i++) reach->previous[i] = -1;
+    reach->start = player;
+    reach->boxVersion = level->boxVersion;
+
+    int front = 0, back = 0;
+    reach->previous[player] = player;
+    reach->queue[back++] = player;
+    while (front < back) {
+        int index = reach->queue[front++];
+        for (int d = 0; d < 4; d++) {
+            int next = neighbour(level, index, d);
+            if (next == -1 || isBox(level, next) || reach->previous[next] != -1) continue;
+            reach->previous[next] = index;
+            reach->queue[back++] = next;
         }
     }
 }
+
+bool canReach(Reach* reach, int index) {
+    return reach->start != -1 && index >= 0 && index < reach->capacity &&
+           reach->previous[index] != -1;
+}
+
+// the walk to target as lowercase lurd letters, out needs room for a letter
+// per cell of the level. returns the number of steps or -1 if it can't be reached
+int findWalk(Reach* reach, int target, char* out) {
+    if (!canReach(reach, target)) return -1;
+
+    int length = 0;
+    for (int index = target; index != reach->start; index = reach->previous[index]) {
+        int step = index - reach->previous[index];
+        out[length++] = step == -1 ? 'l' : step == 1 ? 'r' : step < 0 ? 'u' : 'd';
+    }
+    for (int i = 0; i < length / 2; i++) { // it was followed backwards
+        char c = out[i];
+        out[i] = out[length - 1 - i];
+        out[length - 1 - i] = c;
+    }
+    return length;
+}
+
+void clearReach(Reach* reach) { reach->start = -1; }
+
+void freeReach(Reach* reach) {
+    free(reach->previous);
+    free(reach->queue);
+    *reach = (Reach){ .start = -1 };
+}
@@ -1,31 +1,105 @@
 #ifndef LEVELS_H
 #define LEVELS_H
 
-#include "animation.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 #define NUM_LEVELS 50
+#define MAX_FREEZE_DEPTH 64 // boxes checked at once when looking for a freeze
+#define MAX_JOURNAL_PUSH 63 // longest line of boxes a journal entry can hold
 
-typedef struct {
-    enum { Empty, Border, Box } type;
-    bool isGoal; // Goal or floor?
-    Animation boxSlide;
-} Piece;
-
+// each cell of a level is one bit in these boards
 typedef struct {
     int width;
     int height;
     int playerStartX;
     int playerStartY;
     int numGoals;
-    int goalIndexes[100];
-    Piece* pieces;
-    Piece* original;
+    int completedGoals; // boxes sitting on a goal, kept up to date by moveBox
+    int spareBoxes; // boxes beyond one per goal, they can be left anywhere
+
+    int numWords; // 64 bit words in each board
+    uint64_t* walls;
+    uint64_t* goals;
+    uint64_t* boxes;
+    uint64_t* originalBoxes;
+    uint64_t* deadSquares; // a box on one of these can never reach a goal
+    unsigned int boxVersion; // goes up whenever a box moves
 } Level;
 
-int parseLevels(char* filePath, Level* levels);
+// every level in a collection file, with all their boards in one allocation
+typedef struct {
+    Level* levels;
+    int numLevels;
+    uint64_t* boards;
+} Collection;
+
+// a step the player could take. next is the cell they walk into and end is
+// the cell the line of boxes in front of them moves into, -1 if there's no push
+typedef struct {
+    bool possible;
+    int next;
+    int end;
+} Move;
+
+// every move made on a level, one byte each: the direction in the low two
+// bits (in lurd order) and the number of boxes it pushed in the rest
+typedef struct {
+    uint8_t* moves;
+    int length; // moves past position can still be redone
+    int position; // moves currently applied
+    int capacity;
+} Journal;
+
+// the shortest walks from the player to every cell they can get to without
+// pushing anything. it's only searched again after the player or a box moves
+typedef struct {
+    int* previous; // the cell each one is walked into from, -1 if it can't be reached
+    int* queue;
+    int capacity;
+    int start; // where the walks begin, -1 when nothing's cached
+    unsigned int boxVersion; // of the level it was searched on
+} Reach;
+
+static inline bool getBit(const uint64_t* board, int index) {
+    return (board[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline bool isWall(Level* level, int index) { return getBit(level->walls, index); }
+static inline bool isGoal(Level* level, int index) { return getBit(level->goals, index); }
+static inline bool isBox(Level* level, int index) { return getBit(level->boxes, index); }
+static inline bool isDead(Level* level, int index) { return getBit(level->deadSquares, index); }
+
+int loadCollection(char* filePath, Collection* collection);
+void freeCollection(Collection* collection);
 void restartLevel(Level* level);
 
+void moveBox(Level* level, int from, int to);
 int countCompletedGoals(Level* level);
-void solveLevel(Level* level);
+bool isSolved(Level* level);
+
+// the rules without any animation, the player is a cell index
+Move findMove(Level* level, int player, int deltaX, int deltaY);
+void applyMove(Level* level, Move move);
+bool makeMove(Level* level, int* player, int deltaX, int deltaY);
+bool causesDeadlock(Level* level, int index);
+bool hasDeadlock(Level* level);
+
+int countPushed(Level* level, Move move, int deltaX, int deltaY);
+int recordMove(Journal* journal, int deltaX, int deltaY, int pushed);
+bool undoStep(Journal* journal, int* deltaX, int* deltaY, int* pushed);
+bool redoStep(Journal* journal, int* deltaX, int* deltaY);
+void clearJournal(Journal* journal);
+void freeJournal(Journal* journal);
+
+// lurd strings, lowercase for walks and uppercase for pushes
+int writeLurd(Journal* journal, char* out);
+bool replayLurd(Level* level, const char* moves, int length, int* numMoves, int* numPushes);
+
+void updateReach(Reach* reach, Level* level, int player);
+bool canReach(Reach* reach, int index);
+int findWalk(Reach* reach, int target, char* out);
+void clearReach(Reach* reach);
+void freeReach(Reach* reach);
 
 #endif
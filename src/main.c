@@ -14,6 +14,7 @@ EMSCRIPTEN_KEEPALIVE
 void resize(int width, int height) {
     SetWindowSize(width, height);
     app->windowSize = (Vector2){ width, height };
+    app->dirty = true;
 }
 
 EMSCRIPTEN_KEEPALIVE
@@ -27,9 +28,16 @@ void handleSwipe(const char* direction) {
 
 int main() {
     SetTraceLogLevel(LOG_WARNING);
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
+    // frames follow the display's refresh rate, the game ticks at its own
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT | FLAG_VSYNC_HINT);
     InitWindow(900, 700, "Chickoban");
     InitAudioDevice();
+#if defined(PLATFORM_DESKTOP)
+    // vsync is only a hint, drivers can ignore it. cap at the refresh rate so
+    // the loop doesn't spin flat out when it does
+    int refreshRate = GetMonitorRefreshRate(GetCurrentMonitor());
+    SetTargetFPS(refreshRate > 0 ? refreshRate : 60);
+#endif
 
     app = createApp();
     app->windowSize = (Vector2){ GetScreenWidth(), GetScreenHeight() };
@@ -43,7 +51,6 @@ int main() {
     app->windowSize = (Vector2){ width, height };
     SetWindowSize(width, height);
 #else
-    SetTargetFPS(60);
     while (!app->quit)
         updateApp(app);
 #endif
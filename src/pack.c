@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "pack.h"
+
+// everything is stored in the byte order of the machine that wrote the
+// pack, the magic has a version in it and catches packs from another one
+#define PACK_MAGIC "CKBPACK1"
+#define PACK_ENDIAN 0x01020304
+
+typedef struct {
+    char magic[8];
+    uint32_t endian;
+    uint32_t numLevels;
+} PackHeader; // followed by a uint64_t offset for each level
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    int32_t playerStartX;
+    int32_t playerStartY;
+    int32_t numGoals;
+    int32_t numWords;
+} PackedLevel; // followed by the walls, goals, boxes and dead squares
+
+#define PACKED_BOARDS 4
+
+static size_t packedSize(Level* level) {
+    return sizeof(PackedLevel) + PACKED_BOARDS * level->numWords * sizeof(uint64_t);
+}
+
+// lay the collection out the way it's stored on disk
+int packCollection(Collection* collection, LevelPack* pack) {
+    size_t size = sizeof(PackHeader) + collection->numLevels * sizeof(uint64_t);
+    for (int i = 0; i < collection->numLevels; i++)
+        size += packedSize(&collection->levels[i]);
+
+    uint8_t* data = calloc(1, size);
+    if (data == NULL) return -1;
+
+    PackHeader header = { .endian = PACK_ENDIAN, .numLevels = collection->numLevels };
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    memcpy(data, &header, sizeof(header));
+
+    uint64_t offset = sizeof(PackHeader) + collection->numLevels * sizeof(uint64_t);
+    for (int i = 0; i < collection->numLevels; i++) {
+        Level* level = &collection->levels[i];
+        memcpy(data + sizeof(PackHeader) + i * sizeof(uint64_t), &offset, sizeof(offset));
+
+        PackedLevel packed = {
+            level->width, level->height, level->playerStartX,
+            level->playerStartY, level->numGoals, level->numWords
+        };
+        memcpy(data + offset, &packed, sizeof(packed));
+
+        size_t boardSize = level->numWords * sizeof(uint64_t);
+        uint64_t* boards[PACKED_BOARDS] = {
+            level->walls, level->goals, level->originalBoxes, level->deadSquares
+        };
+        uint8_t* out = data + offset + sizeof(packed);
+        for (int b = 0; b < PACKED_BOARDS; b++, out += boardSize)
+            memcpy(out, boards[b], boardSize);
+        offset += packedSize(level);
+    }
+
+    *pack = (LevelPack){ data, size, collection->numLevels, false };
+    return 0;
+}
+
+int writePack(char* filePath, Collection* collection) {
+    LevelPack pack;
+    if (packCollection(collection, &pack) == -1) return -1;
+
+    FILE* fp = fopen(filePath, "wb");
+    bool written = fp != NULL && fwrite(pack.data, 1, pack.size, fp) == pack.size;
+    if (fp != NULL) written &= fclose(fp) == 0;
+    closePack(&pack);
+    return written ? 0 : -1;
+}
+
+static bool validHeader(LevelPack* pack) {
+    PackHeader header;
+    if (pack->size < sizeof(header)) return false;
+    memcpy(&header, pack->data, sizeof(header));
+    if (memcmp(header.magic, PACK_MAGIC, sizeof(header.magic)) != 0 ||
+        header.endian != PACK_ENDIAN)
+        return false;
+    if (header.numLevels > (pack->size - sizeof(header)) / sizeof(uint64_t)) return false;
+    pack->numLevels = header.numLevels;
+    return true;
+}
+
+// map the pack into memory, only the pages of the levels that get played are read
+int openPack(char* filePath, LevelPack* pack) {
+    *pack = (LevelPack){ 0 };
+#if !defined(_WIN32)
+    int fd = open(filePath, O_RDONLY);
+    if (fd == -1) return -1;
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (data == MAP_FAILED) return -1;
+    *pack = (LevelPack){ data, info.st_size, 0, true };
+#else
+    FILE* fp = fopen(filePath, "rb");
+    if (fp == NULL) return -1;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    uint8_t* data = size > 0 ? malloc(size) : NULL;
+    bool read = data != NULL && fread(data, 1, size, fp) == (size_t)size;
+    fclose(fp);
+    if (!read) {
+        free(data);
+        return -1;
+    }
+    *pack = (LevelPack){ data, size, 0, false };
+#endif
+
+    if (!validHeader(pack)) {
+        closePack(pack);
+        return -1;
+    }
+    return 0;
+}
+
+void closePack(LevelPack* pack) {
+#if !defined(_WIN32)
+    if (pack->mapped) munmap((void*)pack->data, pack->size);
+    else free((void*)pack->data);
+#else
+    free((void*)pack->data);
+#endif
+    *pack = (LevelPack){ 0 };
+}
+
+// decode a level with all its boards in one allocation, free it with cleanupLevel
+int loadPackedLevel(LevelPack* pack, int index, Level* level) {
+    if (index < 0 || index >= pack->numLevels) return -1;
+    uint64_t offset;
+    memcpy(&offset, pack->data + sizeof(PackHeader) + index * sizeof(uint64_t), sizeof(offset));
+    if (offset > pack->size || pack->size - offset < sizeof(PackedLevel)) return -1;
+
+    PackedLevel packed;
+    memcpy(&packed, pack->data + offset, sizeof(packed));
+    size_t boardSize = (size_t)packed.numWords * sizeof(uint64_t);
+    if (packed.width <= 0 || packed.height <= 0 ||
+        packed.numWords != ((int64_t)packed.width * packed.height + 63) / 64 ||
+        pack->size - offset - sizeof(packed) < PACKED_BOARDS * boardSize)
+        return -1;
+
+    uint64_t* boards = malloc(5 * boardSize);
+    if (boards == NULL) return -1;
+    *level = (Level){
+        .width = packed.width, .height = packed.height,
+        .playerStartX = packed.playerStartX, .playerStartY = packed.playerStartY,
+        .numGoals = packed.numGoals,
+        .numWords = packed.numWords,
+        .walls = boards,
+        .goals = boards + packed.numWords,
+        .originalBoxes = boards + 2 * packed.numWords,
+        .deadSquares = boards + 3 * packed.numWords,
+        .boxes = boards + 4 * packed.numWords,
+    };
+    memcpy(boards, pack->data + offset + sizeof(packed), PACKED_BOARDS * boardSize);
+    restartLevel(level);
+    return 0;
+}
+
+void cleanupLevel(Level* level) {
+    free(level->walls);
+    *level = (Level){ 0 };
+}
@@ -0,0 +1,25 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stddef.h>
+#include "levels.h"
+
+// a compiled collection: a header, the offset of each level, then each level's
+// size, player and boards. levels get decoded one at a time straight from the
+// file, so opening a pack costs the same however many levels it holds
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    int numLevels;
+    bool mapped; // data is the file mapped into memory, not an allocation
+} LevelPack;
+
+int writePack(char* filePath, Collection* collection);
+int openPack(char* filePath, LevelPack* pack);
+int packCollection(Collection* collection, LevelPack* pack);
+void closePack(LevelPack* pack);
+
+int loadPackedLevel(LevelPack* pack, int index, Level* level);
+void cleanupLevel(Level* level);
+
+#endif
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <raylib.h>
+#include "profiler.h"
+
+static const char* phaseNames[NumPhases] = {
+    "input", "window", "sound", "menu", "gameloop", "draw3d", "draw2d", "present",
+};
+
+typedef struct {
+    const char* name;
+    double seconds;
+} StartupPhase;
+
+static struct {
+    bool visible;
+    bool recording; // between beginFrame and endFrame or dropFrame
+
+    FrameStats frames[PROFILER_FRAMES];
+    long numFrames; // frames recorded so far, the newest is at (numFrames - 1) % PROFILER_FRAMES
+    FrameStats current;
+    double frameStart;
+    double phaseStarts[NumPhases];
+
+    StartupPhase startup[MAX_STARTUP_PHASES];
+    int numStartup;
+} profiler;
+
+void beginFrame() {
+    profiler.current = (FrameStats){ 0 };
+    profiler.frameStart = GetTime();
+    profiler.recording = true;
+}
+
+void endFrame() {
+    if (!profiler.recording) return;
+    profiler.recording = false;
+    profiler.current.total = GetTime() - profiler.frameStart;
+    profiler.frames[profiler.numFrames++ % PROFILER_FRAMES] = profiler.current;
+}
+
+void dropFrame() { profiler.recording = false; }
+
+void beginPhase(Phase phase) { profiler.phaseStarts[phase] = GetTime(); }
+
+void endPhase(Phase phase) {
+    profiler.current.phases[phase] += GetTime() - profiler.phaseStarts[phase];
+}
+
+void countDrawCall(int triangles) {
+    profiler.current.drawCalls++;
+    profiler.current.triangles += triangles;
+}
+
+void recordStartupPhase(const char* name, double start) {
+    if (profiler.numStartup == MAX_STARTUP_PHASES) return;
+    profiler.startup[profiler.numStartup++] = (StartupPhase){ name, GetTime() - start };
+}
+
+void toggleProfiler() { profiler.visible = !profiler.visible; }
+
+// the last frame next to the average and worst of the recorded ones
+void drawProfiler(Vector2 windowSize, long skippedFrames) {
+    if (!profiler.visible || profiler.numFrames == 0) return;
+
+    long count = profiler.numFrames < PROFILER_FRAMES ? profiler.numFrames : PROFILER_FRAMES;
+    FrameStats last = profiler.frames[(profiler.numFrames - 1) % PROFILER_FRAMES];
+    FrameStats average = { 0 }, worst = { 0 };
+    for (long i = 0; i < count; i++) {
+        FrameStats f = profiler.frames[i];
+        for (int p = 0; p < NumPhases; p++) {
+            average.phases[p] += f.phases[p] / count;
+            if (f.phases[p] > worst.phases[p]) worst.phases[p] = f.phases[p];
+        }
+        average.total += f.total / count;
+        if (f.total > worst.total) worst.total = f.total;
+    }
+
+    int fontSize = 10, lineHeight = 12, width = 250;
+    int x = windowSize.x - width - 10, y = 10;
+    DrawRectangle(x - 5, y - 5, width + 10, (NumPhases + 4) * lineHeight + 10,
+                  (Color){ 0, 0, 0, 160 });
+
+    DrawText(TextFormat("%-10s %8s %8s %8s", "ms", "last", "avg", "worst"),
+             x, y, fontSize, WHITE);
+    y += lineHeight;
+    for (int p = 0; p < NumPhases; p++, y += lineHeight) {
+        DrawText(TextFormat("%-10s %8.3f %8.3f %8.3f", phaseNames[p],
+                            last.phases[p] * 1000, average.phases[p] * 1000,
+                            worst.phases[p] * 1000),
+                 x, y, fontSize, WHITE);
+    }
+    DrawText(TextFormat("%-10s %8.3f %8.3f %8.3f", "total", last.total * 1000,
+                        average.total * 1000, worst.total * 1000),
+             x, y, fontSize, WHITE);
+    y += lineHeight;
+    DrawText(TextFormat("draw calls %d, triangles %d", last.drawCalls, last.triangles),
+             x, y, fontSize, WHITE);
+    y += lineHeight;
+    DrawText(TextFormat("%d fps, %ld idle frames skipped", GetFPS(), skippedFrames),
+             x, y, fontSize, WHITE);
+}
+
+// write the recorded frames oldest first, then the startup phases. frames
+// are recorded whether or not the overlay is showing
+int saveProfile(const char* framesPath, const char* startupPath) {
+    FILE* fp = fopen(framesPath, "w");
+    if (fp == NULL) return -1;
+    fprintf(fp, "frame");
+    for (int p = 0; p < NumPhases; p++) fprintf(fp, ",%s_ms", phaseNames[p]);
+    fprintf(fp, ",total_ms,draw_calls,triangles\n");
+
+    long first = profiler.numFrames > PROFILER_FRAMES ? profiler.numFrames - PROFILER_FRAMES : 0;
+    for (long i = first; i < profiler.numFrames; i++) {
+        FrameStats f = profiler.frames[i % PROFILER_FRAMES];
+        fprintf(fp, "%ld", i);
+        for (int p = 0; p < NumPhases; p++) fprintf(fp, ",%.4f", f.phases[p] * 1000);
+        fprintf(fp, ",%.4f,%d,%d\n", f.total * 1000, f.drawCalls, f.triangles);
+    }
+    fclose(fp);
+
+    fp = fopen(startupPath, "w");
+    if (fp == NULL) return -1;
+    fprintf(fp, "phase,ms\n");
+    for (int i = 0; i < profiler.numStartup; i++)
+        fprintf(fp, "%s,%.4f\n", profiler.startup[i].name, profiler.startup[i].seconds * 1000);
+    fclose(fp);
+    return 0;
+}
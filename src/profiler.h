@@ -0,0 +1,35 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <raylib.h>
+
+#define PROFILER_FRAMES 600 // frames kept in the ring buffer
+#define MAX_STARTUP_PHASES 32
+
+typedef enum {
+    InputPhase, WindowPhase, SoundPhase, MenuPhase, GameloopPhase,
+    Draw3DPhase, Draw2DPhase, PresentPhase, NumPhases,
+} Phase;
+
+typedef struct {
+    double phases[NumPhases]; // seconds
+    double total;
+    int drawCalls;
+    int triangles;
+} FrameStats;
+
+// every beginFrame is paired with an endFrame, or a dropFrame when
+// nothing got drawn so there's no frame to record
+void beginFrame();
+void endFrame();
+void dropFrame();
+void beginPhase(Phase phase);
+void endPhase(Phase phase);
+void countDrawCall(int triangles);
+void recordStartupPhase(const char* name, double start); // start is from GetTime()
+
+void toggleProfiler();
+void drawProfiler(Vector2 windowSize, long skippedFrames);
+int saveProfile(const char* framesPath, const char* startupPath);
+
+#endif
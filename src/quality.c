@@ -0,0 +1,71 @@
+#include "quality.h"
+
+Quality createQuality() {
+    return (Quality){ .tier = FullQuality, .upgradeWindows = MIN_UPGRADE_WINDOWS };
+}
+
+void cleanupQuality(Quality* q) {
+    if (q->target.id != 0) UnloadRenderTexture(q->target);
+    q->target = (RenderTexture2D){ 0 };
+}
+
+static void changeTier(Quality* q, QualityTier tier) {
+    q->upgraded = tier < q->tier;
+    q->tier = tier;
+    q->fastWindows = 0;
+    if (tier < NoMsaa) cleanupQuality(q);
+}
+
+bool updateQuality(Quality* q, double frameTime) {
+    q->frameTimes += frameTime;
+    if (++q->numFrames < QUALITY_WINDOW) return false;
+
+    double average = q->frameTimes / q->numFrames;
+    q->frameTimes = 0;
+    q->numFrames = 0;
+    QualityTier tier = q->tier;
+
+    if (average > SLOW_FRAME_TIME) {
+        if (q->upgraded) { // the better tier was too much after all
+            q->upgradeWindows *= 2;
+            if (q->upgradeWindows > MAX_UPGRADE_WINDOWS) q->upgradeWindows = MAX_UPGRADE_WINDOWS;
+        }
+        if (tier < NumQualityTiers - 1) changeTier(q, tier + 1);
+        q->fastWindows = 0;
+    } else if (average < FAST_FRAME_TIME) {
+        q->upgraded = false;
+        if (tier > FullQuality && ++q->fastWindows >= q->upgradeWindows)
+            changeTier(q, tier - 1);
+    } else {
+        q->upgraded = false;
+        q->fastWindows = 0;
+    }
+    return q->tier != tier;
+}
+
+void beginScene(Quality* q, Vector2 windowSize, Color background) {
+    if (q->tier < NoMsaa) return;
+
+    float scale = q->tier >= LowResolution ? LOW_RESOLUTION_SCALE : 1;
+    int width = windowSize.x * scale, height = windowSize.y * scale;
+    if (width < 1 || height < 1) width = height = 1;
+    if (q->target.texture.width != width || q->target.texture.height != height) {
+        cleanupQuality(q);
+        q->target = LoadRenderTexture(width, height);
+        SetTextureFilter(q->target.texture, TEXTURE_FILTER_BILINEAR);
+    }
+
+    BeginTextureMode(q->target);
+    ClearBackground(background);
+}
+
+void endScene(Quality* q, Vector2 windowSize) {
+    if (q->tier < NoMsaa) return;
+    EndTextureMode();
+
+    // render textures are upside down
+    Texture2D texture = q->target.texture;
+    Rectangle source = { 0, 0, texture.width, -texture.height };
+    Rectangle dest = { 0, 0, windowSize.x, windowSize.y };
+    DrawTexturePro(texture, source, dest, (Vector2){ 0, 0 }, 0, WHITE);
+}
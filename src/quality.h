@@ -0,0 +1,45 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <raylib.h>
+
+// each tier is cheaper to draw than the one before it
+typedef enum {
+    FullQuality, // lit per pixel, with msaa
+    SimpleShading, // lit per vertex
+    NoMsaa, // the scene is drawn into a texture first, which isn't multisampled
+    LowResolution, // that texture at a lower resolution, scaled up
+    NumQualityTiers,
+} QualityTier;
+
+#define QUALITY_WINDOW 60 // frames averaged before deciding anything
+#define SLOW_FRAME_TIME (1.0 / 50) // a window slower than this drops a tier
+#define FAST_FRAME_TIME (1.0 / 57) // a window faster than this counts as headroom
+#define MIN_UPGRADE_WINDOWS 5 // fast windows in a row before trying a better tier
+#define MAX_UPGRADE_WINDOWS 80
+#define LOW_RESOLUTION_SCALE 0.6
+
+typedef struct {
+    QualityTier tier;
+    double frameTimes; // summed over the current window, leaving out the swap
+    int numFrames;
+
+    // going up a tier is a guess, the gpu's share of a frame is spent in the
+    // swap, which isn't timed. when it doesn't last we wait twice as long
+    // before trying again
+    int fastWindows;
+    int upgradeWindows;
+    bool upgraded; // the last change went up a tier
+
+    RenderTexture2D target; // holds the scene from NoMsaa down
+} Quality;
+
+Quality createQuality();
+void cleanupQuality(Quality* q);
+bool updateQuality(Quality* q, double frameTime); // true when the tier changed
+
+// wrap the 3d drawing, it goes through the render texture on the lower tiers
+void beginScene(Quality* q, Vector2 windowSize, Color background);
+void endScene(Quality* q, Vector2 windowSize);
+
+#endif
@@ -0,0 +1,1592 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "solver.h"
+
+#define UNREACHABLE 0xffff
+
+// the open list is split by how many goals are packed and how many areas the
+// boxes cut the floor into. taking a node from each part in turn keeps the
+// search from sinking everything into the part that looks closest to solved
+#define MAX_REGIONS 8
+#define MACRO_PUSH 4
+#define BACKWARD_WEIGHT 3
+#define BACKWARD_NODE 0x80 // set on the push direction of nodes found searching backwards // push direction of a node that pushed one box all the way to a goal
+
+// directions in LURD order, the opposite direction is (d + 2) % 4
+static const int directionX[4] = { -1, 0, 1, 0 };
+static const int directionY[4] = { 0, -1, 0, 1 };
+static const char directionNames[] = "lurd";
+
+typedef struct {
+    uint64_t* keys; // keyed by (weight, estimate, node)
+    int size;
+    int capacity;
+} OpenList;
+
+// boxes are matched against a set of target cells, the goals when pushing
+// and the cells the boxes started on when pulling back from the solved level
+typedef struct {
+    int count;
+    unsigned short* minDistance; // fewest moves from a cell to any target
+    unsigned short* distances; // fewest moves from a cell to each target
+    unsigned short* order; // targets sorted by distance for each cell
+} Targets;
+
+typedef struct {
+    int numCells; // floor cells the player can reach when ignoring boxes
+    int numWords; // 64 bit words in a set of boxes
+    int numGoals;
+    int spareBoxes; // boxes beyond one per goal, they can be left anywhere
+    int* cells; // level index of each floor cell
+    int (*neighbours)[4]; // -1 when there's a wall in that direction
+    bool* isGoal;
+    bool* isDead; // a box on this cell can never reach a goal
+    Targets goals;
+    Targets starts;
+    uint64_t* startBoxes;
+    int* packingOrder; // goal cells in the order they should be filled
+    uint64_t* boxKeys; // zobrist keys
+    uint64_t* playerKeys;
+
+    // search nodes stored as parallel arrays
+    int capacity;
+    int numNodes;
+    uint64_t* boxes;
+    uint64_t* hashes;
+    int* parents;
+    unsigned short* players; // normalized player position, the smallest reachable cell
+    unsigned short* pushCells; // cell the pushed box moved from
+    unsigned char* pushDirections;
+
+    int* table; // transposition table holding node index + 1, 0 when empty
+    size_t tableMask;
+
+    OpenList* open; // one for each number of packed goals and regions
+    int numOpen;
+    OpenList backwardOpen;
+    long nodesExpanded;
+    bool outOfMemory;
+
+    // the solution goes forwards to one node and carries on backwards from the
+    // other, -1 when there's nothing on that side
+    int meetForward;
+    int meetBackward;
+
+    // scratch space
+    uint64_t* current;
+    uint64_t* allowed;
+    int stamp;
+    int* queue;
+    int* came;
+    int* visited;
+    int* pullVisited;
+    int* sideVisited; // four for each cell, one for each side of a box on it
+    int* sideParents;
+    int* sideQueue;
+    int* path;
+    int* childVisited;
+    int* boxList;
+    int* targetTaken;
+    bool* checking; // boxes currently being checked for a freeze deadlock
+    int* corral; // which corral each cell belongs to, -1 when it's in no corral
+    int* corralPushes;
+    bool* corralUseful; // the corral still needs boxes moved into or out of it
+    bool* corralPruning; // every push around the corral goes into it
+} Solver;
+
+static bool hasBox(const uint64_t* boxes, int cell) {
+    return (boxes[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static void toggleBox(uint64_t* boxes, int cell) {
+    boxes[cell >> 6] ^= (uint64_t)1 << (cell & 63);
+}
+
+static uint64_t* nodeBoxes(Solver* s, int node) {
+    return &s->boxes[(size_t)node * s->numWords];
+}
+
+static uint64_t nextRandom(uint64_t* state) { // xorshift64
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// flood fill the cells the player can walk to and return the smallest one
+static int reach(Solver* s, const uint64_t* boxes, int start, int* visited) {
+    int head = 0, tail = 0, smallest = start;
+    s->stamp++;
+    visited[start] = s->stamp;
+    s->queue[tail++] = start;
+
+    while (head < tail) {
+        int cell = s->queue[head++];
+        if (cell < smallest) smallest = cell;
+        for (int d = 0; d < 4; d++) {
+            int next = s->neighbours[cell][d];
+            if (next < 0 || visited[next] == s->stamp || hasBox(boxes, next))
+                continue;
+            visited[next] = s->stamp;
+            s->queue[tail++] = next;
+        }
+    }
+    return smallest;
+}
+
+// fewest pushes needed to get a box from any cell onto the goal,
+// found by pulling a box backwards from the goal
+static void pullDistances(Solver* s, int goal, unsigned short* distance) {
+    for (int i = 0; i < s->numCells; i++)
+        distance[i] = UNREACHABLE;
+
+    int head = 0, tail = 0;
+    distance[goal] = 0;
+    s->queue[tail++] = goal;
+
+    while (head < tail) {
+        int cell = s->queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int box = s->neighbours[cell][d]; // where the box was before the push
+            int player = box < 0 ? -1 : s->neighbours[box][d];
+            if (player < 0 || distance[box] != UNREACHABLE) continue;
+            distance[box] = distance[cell] + 1;
+            s->queue[tail++] = box;
+        }
+    }
+}
+
+// fewest pushes to get a box from the start cell to every other cell
+static void pushDistances(Solver* s, int start, unsigned short* distance) {
+    for (int i = 0; i < s->numCells; i++)
+        distance[i] = UNREACHABLE;
+
+    int head = 0, tail = 0;
+    distance[start] = 0;
+    s->queue[tail++] = start;
+
+    while (head < tail) {
+        int cell = s->queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int next = s->neighbours[cell][d];
+            int player = s->neighbours[cell][(d + 2) % 4];
+            if (next < 0 || player < 0 || distance[next] != UNREACHABLE) continue;
+            distance[next] = distance[cell] + 1;
+            s->queue[tail++] = next;
+        }
+    }
+}
+
+// distances from every cell to each target, found by pulling boxes
+// away from the goals or pushing them away from where they start
+static void setupTargets(Solver* s, Targets* t, const bool* isTarget, bool pushing) {
+    int n = s->numCells;
+    t->minDistance = malloc(n * sizeof(unsigned short));
+    t->distances = malloc((size_t)t->count * n * sizeof(unsigned short));
+    t->order = malloc((size_t)t->count * n * sizeof(unsigned short));
+    for (int i = 0; i < n; i++) t->minDistance[i] = UNREACHABLE;
+
+    for (int i = 0, target = 0; i < n; i++) {
+        if (!isTarget[i]) continue;
+        unsigned short* distance = &t->distances[(size_t)target++ * n];
+        if (pushing) pushDistances(s, i, distance);
+        else pullDistances(s, i, distance);
+        for (int j = 0; j < n; j++)
+            if (distance[j] < t->minDistance[j]) t->minDistance[j] = distance[j];
+    }
+
+    for (int i = 0; i < n; i++) {
+        unsigned short* order = &t->order[(size_t)i * t->count];
+        for (int g = 0; g < t->count; g++) {
+            int j = g;
+            unsigned short distance = t->distances[(size_t)g * n + i];
+            for (; j > 0 && t->distances[(size_t)order[j - 1] * n + i] > distance; j--)
+                order[j] = order[j - 1];
+            order[j] = g;
+        }
+    }
+}
+
+static void cleanupTargets(Targets* t) {
+    free(t->minDistance);
+    free(t->distances);
+    free(t->order);
+}
+
+// pushing moves the whole line of boxes in front of the player, so a box is
+// only stuck along an axis when one side is a wall, maybe behind a line of
+// boxes that are stuck along the other axis, or when both sides are dead
+// squares. boxes that are already being checked are assumed to be free. a spare
+// box can be pushed onto a dead square, so the last rule needs every box
+static bool blockedAlongAxis(Solver* s, const uint64_t* boxes, int cell, int axis) {
+    if (s->checking[cell]) return false;
+
+    int a = s->neighbours[cell][axis];
+    int b = s->neighbours[cell][axis + 2];
+    if (s->spareBoxes == 0 && a >= 0 && b >= 0 && !hasBox(boxes, a) &&
+        !hasBox(boxes, b) && s->isDead[a] && s->isDead[b])
+        return true;
+
+    s->checking[cell] = true;
+    bool blocked = false;
+    for (int side = axis; side < 4 && !blocked; side += 2) {
+        int next = s->neighbours[cell][side];
+        while (next >= 0 && hasBox(boxes, next) &&
+               blockedAlongAxis(s, boxes, next, 1 - axis))
+            next = s->neighbours[next][side];
+        blocked = next < 0;
+    }
+    s->checking[cell] = false;
+    return blocked;
+}
+
+// a box that can't move along either axis is stuck there for good
+static bool isFrozen(Solver* s, const uint64_t* boxes, int cell) {
+    return blockedAlongAxis(s, boxes, cell, 0) && blockedAlongAxis(s, boxes, cell, 1);
+}
+
+// more boxes are stuck than there are spare boxes to leave behind
+static bool tooManyStuck(Solver* s, const uint64_t* boxes) {
+    int stuck = 0;
+    for (int cell = 0; cell < s->numCells; cell++) {
+        if (!hasBox(boxes, cell)) continue;
+        if (s->isDead[cell] || (!s->isGoal[cell] && isFrozen(s, boxes, cell)))
+            if (++stuck > s->spareBoxes) return true;
+    }
+    return false;
+}
+
+// a box arriving on a cell can freeze itself or the boxes next to it
+static bool isDeadlocked(Solver* s, const uint64_t* boxes, int cell) {
+    if (s->spareBoxes > 0) return tooManyStuck(s, boxes);
+    if (!s->isGoal[cell] && isFrozen(s, boxes, cell)) return true;
+    for (int d = 0; d < 4; d++) {
+        int next = s->neighbours[cell][d];
+        if (next >= 0 && hasBox(boxes, next) && !s->isGoal[next] &&
+            isFrozen(s, boxes, next))
+            return true;
+    }
+    return false;
+}
+
+// pair boxes with the closest target that hasn't been taken yet, starting with
+// the boxes that are closest to a target. it's cheaper than an optimal matching
+// and keeps boxes from all heading for the same target
+static int estimateCost(Solver* s, Targets* t, const uint64_t* boxes) {
+    int numBoxes = 0;
+    for (int w = 0; w < s->numWords; w++) {
+        if (boxes[w] == 0) continue;
+        for (int bit = 0; bit < 64; bit++) {
+            if (!((boxes[w] >> bit) & 1)) continue;
+            int cell = w * 64 + bit, j = numBoxes++;
+            for (; j > 0 && t->minDistance[s->boxList[j - 1]] > t->minDistance[cell]; j--)
+                s->boxList[j] = s->boxList[j - 1];
+            s->boxList[j] = cell;
+        }
+    }
+
+    s->stamp++;
+    int total = 0, taken = 0;
+    for (int i = 0; i < numBoxes && taken < t->count; i++) {
+        int cell = s->boxList[i];
+        int cost = t->minDistance[cell];
+        unsigned short* order = &t->order[(size_t)cell * t->count];
+        for (int g = 0; g < t->count; g++) {
+            int target = order[g];
+            unsigned short distance = t->distances[(size_t)target * s->numCells + cell];
+            if (distance == UNREACHABLE) break;
+            if (s->targetTaken[target] != s->stamp) {
+                s->targetTaken[target] = s->stamp;
+                cost = distance;
+                break;
+            }
+        }
+        total += cost;
+        taken++;
+    }
+    return total < UNREACHABLE ? total : UNREACHABLE - 1; // it's stored in 16 bits
+}
+
+static bool onCorralEdge(Solver* s, const uint64_t* boxes, int cell, int reachable) {
+    if (!hasBox(boxes, cell)) return false;
+    for (int d = 0; d < 4; d++) {
+        int next = s->neighbours[cell][d];
+        if (next >= 0 && s->visited[next] == reachable) return true;
+    }
+    return false;
+}
+
+// a corral is an area the player can't get into. when every push the player
+// can make on the boxes around a corral goes into it, one of those pushes has
+// to happen before the corral can be solved, so the rest can be ignored (pi-corral
+// pruning). fills allowed with the boxes that may be pushed and returns false
+// when a corral needs work but none of the boxes around it can be pushed in
+static bool pruneCorrals(
+    Solver* s, const uint64_t* boxes, int reachable, uint64_t* allowed) {
+    // a spare box doesn't have to go anywhere, so no push is forced
+    if (s->spareBoxes > 0) return true;
+
+    // boxes touching the player's area are on the edge of a corral,
+    // every other cell the player can't reach is inside one
+    int numCorrals = 0;
+    for (int i = 0; i < s->numCells; i++) s->corral[i] = -1;
+    for (int i = 0; i < s->numCells; i++) {
+        if (s->visited[i] == reachable || s->corral[i] != -1 ||
+            onCorralEdge(s, boxes, i, reachable))
+            continue;
+
+        int id = numCorrals++;
+        s->corralPushes[id] = 0;
+        s->corralUseful[id] = false;
+        s->corralPruning[id] = true;
+
+        int head = 0, tail = 0;
+        s->corral[i] = id;
+        s->queue[tail++] = i;
+        while (head < tail) {
+            int cell = s->queue[head++];
+            if (s->isGoal[cell] != hasBox(boxes, cell)) s->corralUseful[id] = true;
+            for (int d = 0; d < 4; d++) {
+                int next = s->neighbours[cell][d];
+                if (next < 0 || s->corral[next] != -1 ||
+                    s->visited[next] == reachable ||
+                    onCorralEdge(s, boxes, next, reachable))
+                    continue;
+                s->corral[next] = id;
+                s->queue[tail++] = next;
+            }
+        }
+    }
+    if (numCorrals == 0) return true;
+
+    // look at every push of the boxes on the edges
+    for (int box = 0; box < s->numCells; box++) {
+        if (!hasBox(boxes, box) || s->corral[box] != -1) continue;
+
+        int touching[4], numTouching = 0;
+        for (int d = 0; d < 4; d++) {
+            int next = s->neighbours[box][d];
+            if (next < 0 || s->corral[next] == -1) continue;
+            int id = s->corral[next];
+            bool seen = false;
+            for (int j = 0; j < numTouching; j++) seen |= touching[j] == id;
+            if (!seen) touching[numTouching++] = id;
+            if (!s->isGoal[box]) s->corralUseful[id] = true;
+        }
+
+        for (int d = 0; d < 4; d++) {
+            int to = s->neighbours[box][d];
+            int from = s->neighbours[box][(d + 2) % 4];
+            if (to < 0 || from < 0) continue;
+            int into = s->corral[to];
+
+            if (into == -1) {
+                // a push away from the corrals, either now or once the player
+                // or the boxes in the way have moved. only pushing onto a
+                // dead square is ruled out for good
+                if (hasBox(boxes, to) || !s->isDead[to])
+                    for (int j = 0; j < numTouching; j++)
+                        s->corralPruning[touching[j]] = false;
+                continue;
+            }
+
+            // the boxes in front only stay put while they're all inside the corral
+            int end = to;
+            bool inside = true;
+            while (end >= 0 && hasBox(boxes, end)) {
+                inside &= s->corral[end] == into;
+                end = s->neighbours[end][d];
+            }
+            bool blocked = end < 0 || s->isDead[end];
+            bool possible = !blocked && s->visited[from] == reachable;
+
+            for (int j = 0; j < numTouching; j++) {
+                if (touching[j] != into) s->corralPruning[touching[j]] = false;
+                else if (possible) s->corralPushes[into]++;
+                else if (!blocked || !inside) s->corralPruning[into] = false;
+            }
+        }
+    }
+
+    int best = -1;
+    for (int id = 0; id < numCorrals; id++) {
+        if (!s->corralPruning[id] || !s->corralUseful[id]) continue;
+        if (s->corralPushes[id] == 0) return false; // nothing can get in or out
+        if (best == -1 || s->corralPushes[id] < s->corralPushes[best]) best = id;
+    }
+    if (best == -1) return true;
+
+    memset(allowed, 0, s->numWords * sizeof(uint64_t));
+    for (int box = 0; box < s->numCells; box++) {
+        if (!hasBox(boxes, box) || s->corral[box] != -1) continue;
+        for (int d = 0; d < 4; d++) {
+            int next = s->neighbours[box][d];
+            if (next >= 0 && s->corral[next] == best) {
+                toggleBox(allowed, box);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// label which sides of a cell the player can walk between while a box sits on
+// it. sides[d] is the first side that's joined to side d, or -1 when it's blocked
+static void labelSides(Solver* s, const uint64_t* obstacles, int cell, signed char* sides) {
+    for (int d = 0; d < 4; d++) {
+        int next = s->neighbours[cell][d];
+        sides[d] = next < 0 || hasBox(obstacles, next) ? -1 : d;
+    }
+
+    for (int d = 0; d < 3; d++) {
+        if (sides[d] != d) continue;
+        int head = 0, tail = 0;
+        s->stamp++;
+        s->childVisited[cell] = s->stamp;
+        s->childVisited[s->neighbours[cell][d]] = s->stamp;
+        s->queue[tail++] = s->neighbours[cell][d];
+        while (head < tail) {
+            int at = s->queue[head++];
+            for (int e = 0; e < 4; e++) {
+                int next = s->neighbours[at][e];
+                if (next < 0 || s->childVisited[next] == s->stamp ||
+                    hasBox(obstacles, next))
+                    continue;
+                s->childVisited[next] = s->stamp;
+                s->queue[tail++] = next;
+            }
+        }
+        for (int e = d + 1; e < 4; e++)
+            if (sides[e] == e && s->childVisited[s->neighbours[cell][e]] == s->stamp)
+                sides[e] = d;
+    }
+}
+
+typedef struct {
+    const uint64_t* filled; // goals that still have a box
+    const bool* isSource; // cells boxes start on, off the goals
+    bool* outside; // cells the player can reach from the starting cells
+    signed char (*sides)[4];
+    int* labelled; // round each cell's sides were labelled in
+    int round; // goes up each time a box is taken out
+    int* seen; // search each (cell, side) state was seen in
+    int search;
+    int* states;
+} Extraction;
+
+static signed char* sidesOf(Solver* s, Extraction* e, int cell) {
+    if (e->labelled[cell] != e->round) {
+        labelSides(s, e->filled, cell, e->sides[cell]);
+        e->labelled[cell] = e->round;
+    }
+    return e->sides[cell];
+}
+
+// fewest pulls to take the box on the goal back to a cell boxes start on, or
+// to anywhere off the goals, with the player coming from the start area.
+// -1 when it can't get out
+static int extractBox(Solver* s, Extraction* e, int goal, bool anywhere) {
+    int head = 0, tail = 0;
+    e->search++;
+    signed char* sides = sidesOf(s, e, goal);
+    for (int d = 0; d < 4; d++) {
+        if (sides[d] == -1 || !e->outside[s->neighbours[goal][d]]) continue;
+        int state = goal * 4 + sides[d];
+        if (e->seen[state] == e->search) continue;
+        e->seen[state] = e->search;
+        e->states[tail++] = state;
+    }
+
+    // states are handled a whole number of pulls at a time
+    for (int pulls = 0; head < tail; pulls++) {
+        for (int end = tail; head < end; head++) {
+            int cell = e->states[head] / 4, side = e->states[head] % 4;
+            if (e->isSource[cell] || (anywhere && !s->isGoal[cell] && e->outside[cell])) return pulls;
+
+            sides = sidesOf(s, e, cell);
+            for (int d = 0; d < 4; d++) {
+                if (sides[d] != side) continue;
+                int to = s->neighbours[cell][d]; // the box follows the player here
+                int player = s->neighbours[to][d];
+                if (player < 0 || hasBox(e->filled, player)) continue;
+
+                int state = to * 4 + sidesOf(s, e, to)[d];
+                if (e->seen[state] == e->search) continue;
+                e->seen[state] = e->search;
+                e->states[tail++] = state;
+            }
+        }
+    }
+    return -1;
+}
+
+// work backwards from the solved level, each time taking out the box that's
+// the fewest pulls away from where the boxes start. the goals deep inside a
+// goal room come out last, so they're the first to be filled
+static void findPackingOrder(Solver* s, const uint64_t* start) {
+    int n = s->numCells;
+    uint64_t* filled = calloc(s->numWords, sizeof(uint64_t));
+    bool* isSource = calloc(n, sizeof(bool));
+    Extraction e = {
+        .filled = filled,
+        .isSource = isSource,
+        .outside = malloc(n * sizeof(bool)),
+        .sides = malloc(n * sizeof(*e.sides)),
+        .labelled = calloc(n, sizeof(int)),
+        .seen = calloc(n * 4, sizeof(int)),
+        .states = malloc(n * 4 * sizeof(int)),
+    };
+
+    for (int i = 0; i < n; i++) {
+        if (s->isGoal[i]) toggleBox(filled, i);
+        isSource[i] = hasBox(start, i) && !s->isGoal[i];
+    }
+
+    int remaining = s->numGoals;
+    while (remaining > 0) {
+        // the player comes in from anywhere connected to the boxes' starting cells
+        int head = 0, tail = 0;
+        for (int i = 0; i < n; i++) {
+            e.outside[i] = isSource[i];
+            if (isSource[i]) s->queue[tail++] = i;
+        }
+        while (head < tail) {
+            int cell = s->queue[head++];
+            for (int d = 0; d < 4; d++) {
+                int next = s->neighbours[cell][d];
+                if (next < 0 || e.outside[next] || hasBox(filled, next)) continue;
+                e.outside[next] = true;
+                s->queue[tail++] = next;
+            }
+        }
+
+        // the filled goals don't change while looking, so the labels are shared.
+        // when no box can get back to the start, it's parked somewhere off the goals
+        int best = -1, fewest = 0;
+        e.round++;
+        for (int pass = 0; pass < 2 && best == -1; pass++) {
+            for (int i = 0; i < n; i++) {
+                if (!hasBox(filled, i)) continue;
+                int pulls = extractBox(s, &e, i, pass == 1);
+                if (pulls >= 0 && (best == -1 || pulls < fewest)) {
+                    best = i;
+                    fewest = pulls;
+                }
+            }
+        }
+        if (best == -1) break;
+        s->packingOrder[--remaining] = best;
+        toggleBox(filled, best);
+    }
+
+    // whatever can't be taken out is filled first
+    for (int i = 0; remaining > 0 && i < n; i++)
+        if (hasBox(filled, i)) s->packingOrder[--remaining] = i;
+
+    free(filled);
+    free(isSource);
+    free(e.outside);
+    free(e.sides);
+    free(e.labelled);
+    free(e.seen);
+    free(e.states);
+}
+
+// how far along the packing order the goals are filled
+static int countPacked(Solver* s, const uint64_t* boxes) {
+    int packed = 0;
+    while (packed < s->numGoals && hasBox(boxes, s->packingOrder[packed]))
+        packed++;
+    return packed;
+}
+
+// separate areas of floor the boxes cut the level into, up to MAX_REGIONS - 1
+static int countRegions(Solver* s, const uint64_t* boxes) {
+    int regions = 0;
+    s->stamp++;
+    for (int i = 0; i < s->numCells && regions < MAX_REGIONS - 1; i++) {
+        if (s->childVisited[i] == s->stamp || hasBox(boxes, i)) continue;
+        regions++;
+        int head = 0, tail = 0;
+        s->childVisited[i] = s->stamp;
+        s->queue[tail++] = i;
+        while (head < tail) {
+            int cell = s->queue[head++];
+            for (int d = 0; d < 4; d++) {
+                int next = s->neighbours[cell][d];
+                if (next < 0 || s->childVisited[next] == s->stamp || hasBox(boxes, next))
+                    continue;
+                s->childVisited[next] = s->stamp;
+                s->queue[tail++] = next;
+            }
+        }
+    }
+    return regions;
+}
+
+static bool setupSolver(
+    Solver* s, Level* level, int playerX, int playerY, size_t memoryLimit) {
+    int size = level->width * level->height;
+    int* cellOf = malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++) cellOf[i] = -1;
+
+    // the floor is whatever the player can reach when there are no boxes
+    s->cells = malloc(size * sizeof(int));
+    int start = playerY * level->width + playerX;
+    cellOf[start] = 0;
+    s->cells[s->numCells++] = start;
+    for (int head = 0; head < s->numCells; head++) {
+        int x = s->cells[head] % level->width;
+        int y = s->cells[head] / level->width;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + directionX[d], ny = y + directionY[d];
+            if (nx < 0 || ny < 0 || nx >= level->width || ny >= level->height)
+                continue;
+            int index = ny * level->width + nx;
+            if (cellOf[index] != -1 || isWall(level, index))
+                continue;
+            cellOf[index] = s->numCells;
+            s->cells[s->numCells++] = index;
+        }
+    }
+
+    int n = s->numCells;
+    s->numWords = (n + 63) / 64;
+    s->neighbours = malloc(n * sizeof(*s->neighbours));
+    s->isGoal = calloc(n, sizeof(bool));
+    s->isDead = calloc(n, sizeof(bool));
+    s->boxKeys = malloc(n * sizeof(uint64_t));
+    s->playerKeys = malloc(n * sizeof(uint64_t));
+    s->queue = malloc(n * sizeof(int));
+    s->current = malloc(s->numWords * sizeof(uint64_t));
+    s->allowed = malloc(s->numWords * sizeof(uint64_t));
+    s->came = malloc(n * sizeof(int));
+    s->visited = calloc(n, sizeof(int));
+    s->pullVisited = calloc(n, sizeof(int));
+    s->sideVisited = calloc(n * 4, sizeof(int));
+    s->sideParents = malloc(n * 4 * sizeof(int));
+    s->sideQueue = malloc(n * 4 * sizeof(int));
+    s->path = malloc(n * 4 * sizeof(int));
+    s->childVisited = calloc(n, sizeof(int));
+    s->boxList = malloc(n * sizeof(int));
+    s->checking = calloc(n, sizeof(bool));
+    s->corral = malloc(n * sizeof(int));
+    s->corralPushes = malloc(n * sizeof(int));
+    s->corralUseful = malloc(n * sizeof(bool));
+    s->corralPruning = malloc(n * sizeof(bool));
+
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    int numBoxes = 0;
+    for (int i = 0; i < n; i++) {
+        int x = s->cells[i] % level->width;
+        int y = s->cells[i] / level->width;
+        for (int d = 0; d < 4; d++) {
+            int nx = x + directionX[d], ny = y + directionY[d];
+            bool inside = nx >= 0 && ny >= 0 && nx < level->width && ny < level->height;
+            s->neighbours[i][d] = inside ? cellOf[ny * level->width + nx] : -1;
+        }
+
+        s->isGoal[i] = isGoal(level, s->cells[i]);
+        s->numGoals += s->isGoal[i];
+        numBoxes += isBox(level, s->cells[i]);
+        s->boxKeys[i] = nextRandom(&seed);
+        s->playerKeys[i] = nextRandom(&seed);
+    }
+    free(cellOf);
+
+    // the win condition is every goal being covered
+    if (s->numGoals == 0 || numBoxes < s->numGoals) return false;
+    s->spareBoxes = numBoxes - s->numGoals;
+
+    s->targetTaken = calloc(numBoxes, sizeof(int));
+    s->goals.count = s->numGoals;
+    setupTargets(s, &s->goals, s->isGoal, false);
+    for (int i = 0; i < n; i++) s->isDead[i] = s->goals.minDistance[i] == UNREACHABLE;
+
+    s->startBoxes = calloc(s->numWords, sizeof(uint64_t));
+    bool* isStart = calloc(n, sizeof(bool));
+    for (int i = 0; i < n; i++) {
+        if (!isBox(level, s->cells[i])) continue;
+        toggleBox(s->startBoxes, i);
+        isStart[i] = true;
+    }
+    s->starts.count = numBoxes;
+    setupTargets(s, &s->starts, isStart, true);
+    free(isStart);
+
+    s->packingOrder = malloc(s->numGoals * sizeof(int));
+    findPackingOrder(s, s->startBoxes);
+
+    s->numOpen = (s->numGoals + 1) * MAX_REGIONS;
+    s->open = calloc(s->numOpen, sizeof(OpenList));
+
+    // size the node storage to fit the memory limit
+    size_t perNode = s->numWords * sizeof(uint64_t) + sizeof(uint64_t) +
+                     sizeof(int) + 2 * sizeof(unsigned short) + 1 +
+                     sizeof(uint64_t) + 2 * sizeof(int);
+    size_t capacity = memoryLimit / perNode;
+    if (capacity > 0xfffffff) capacity = 0xfffffff; // node indexes are packed into 28 bits
+    if (capacity < 1) return false;
+
+    size_t tableSize = 1;
+    while (tableSize < capacity * 2) tableSize <<= 1;
+    s->capacity = capacity;
+    s->tableMask = tableSize - 1;
+    s->boxes = malloc(capacity * s->numWords * sizeof(uint64_t));
+    s->hashes = malloc(capacity * sizeof(uint64_t));
+    s->parents = malloc(capacity * sizeof(int));
+    s->players = malloc(capacity * sizeof(unsigned short));
+    s->pushCells = malloc(capacity * sizeof(unsigned short));
+    s->pushDirections = malloc(capacity);
+    s->table = calloc(tableSize, sizeof(int)); // zeroed pages are mapped lazily
+    return s->boxes && s->hashes && s->parents && s->players && s->pushCells &&
+           s->pushDirections && s->table;
+}
+
+static void cleanupSolver(Solver* s) {
+    free(s->cells);
+    free(s->neighbours);
+    free(s->isGoal);
+    free(s->isDead);
+    cleanupTargets(&s->goals);
+    cleanupTargets(&s->starts);
+    free(s->startBoxes);
+    free(s->packingOrder);
+    free(s->boxKeys);
+    free(s->playerKeys);
+    free(s->boxes);
+    free(s->hashes);
+    free(s->parents);
+    free(s->players);
+    free(s->pushCells);
+    free(s->pushDirections);
+    free(s->table);
+    for (int i = 0; i < s->numOpen; i++) free(s->open[i].keys);
+    free(s->open);
+    free(s->backwardOpen.keys);
+    free(s->current);
+    free(s->allowed);
+    free(s->queue);
+    free(s->came);
+    free(s->visited);
+    free(s->pullVisited);
+    free(s->sideVisited);
+    free(s->sideParents);
+    free(s->sideQueue);
+    free(s->path);
+    free(s->childVisited);
+    free(s->boxList);
+    free(s->targetTaken);
+    free(s->checking);
+    free(s->corral);
+    free(s->corralPushes);
+    free(s->corralUseful);
+    free(s->corralPruning);
+}
+
+static bool openPush(OpenList* list, uint64_t key) {
+    if (list->size == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        uint64_t* keys = realloc(list->keys, capacity * sizeof(uint64_t));
+        if (keys == NULL) return false;
+        list->keys = keys;
+        list->capacity = capacity;
+    }
+
+    int i = list->size++;
+    while (i > 0 && list->keys[(i - 1) / 2] > key) {
+        list->keys[i] = list->keys[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    list->keys[i] = key;
+    return true;
+}
+
+static uint64_t openPop(OpenList* list) {
+    uint64_t top = list->keys[0];
+    uint64_t last = list->keys[--list->size];
+    int i = 0;
+    while (true) {
+        int child = i * 2 + 1;
+        if (child >= list->size) break;
+        if (child + 1 < list->size && list->keys[child + 1] < list->keys[child])
+            child++;
+        if (list->keys[child] >= last) break;
+        list->keys[i] = list->keys[child];
+        i = child;
+    }
+    list->keys[i] = last;
+    return top;
+}
+
+// look for a node in the transposition table, returning -1 when it's missing
+static int findNode(
+    Solver* s, const uint64_t* boxes, uint64_t hash, int player, size_t* slot) {
+    size_t i = hash & s->tableMask;
+    while (s->table[i] != 0) {
+        int node = s->table[i] - 1;
+        if (s->hashes[node] == hash && s->players[node] == player &&
+            memcmp(nodeBoxes(s, node), boxes, s->numWords * sizeof(uint64_t)) == 0) {
+            *slot = i;
+            return node;
+        }
+        i = (i + 1) & s->tableMask;
+    }
+    *slot = i;
+    return -1;
+}
+
+static int addNode(
+    Solver* s, const uint64_t* boxes, uint64_t hash, int player, size_t slot) {
+    if (s->numNodes == s->capacity) return -1;
+    int node = s->numNodes++;
+    memcpy(nodeBoxes(s, node), boxes, s->numWords * sizeof(uint64_t));
+    s->hashes[node] = hash;
+    s->players[node] = player;
+    s->table[slot] = node + 1;
+    return node;
+}
+
+typedef struct {
+    char* str;
+    int length;
+    int capacity;
+} Moves;
+
+static void appendMove(Moves* m, char c) {
+    if (m->length + 1 >= m->capacity) {
+        m->capacity = m->capacity ? m->capacity * 2 : 256;
+        m->str = realloc(m->str, m->capacity);
+    }
+    m->str[m->length++] = c;
+    m->str[m->length] = '\0';
+}
+
+// append the shortest walk between two cells, going around the boxes
+static void appendWalk(Solver* s, Moves* m, const uint64_t* boxes, int from, int to) {
+    int head = 0, tail = 0;
+    s->stamp++;
+    s->visited[from] = s->stamp;
+    s->queue[tail++] = from;
+
+    while (head < tail && s->visited[to] != s->stamp) {
+        int cell = s->queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int next = s->neighbours[cell][d];
+            if (next < 0 || s->visited[next] == s->stamp || hasBox(boxes, next))
+                continue;
+            s->visited[next] = s->stamp;
+            s->came[next] = d; // direction taken to step onto the cell
+            s->queue[tail++] = next;
+        }
+    }
+
+    // walk back from the target, then write the steps out in order
+    int length = 0;
+    for (int cell = to; cell != from; length++) {
+        s->queue[length] = s->came[cell];
+        cell = s->neighbours[cell][(s->came[cell] + 2) % 4];
+    }
+    while (length > 0)
+        appendMove(m, directionNames[s->queue[--length]]);
+}
+
+// pull backwards from the goal around the other boxes, ignoring where the player
+// can walk, to find the boxes that might be pushed onto it. the boxes are
+// listed closest first and returns how many there are
+static int findPackingBoxes(Solver* s, const uint64_t* boxes, int goal) {
+    int head = 0, tail = 0, numBoxes = 0;
+    s->stamp++;
+    s->pullVisited[goal] = s->stamp;
+    s->queue[tail++] = goal;
+
+    while (head < tail) {
+        int cell = s->queue[head++];
+        for (int d = 0; d < 4; d++) {
+            int box = s->neighbours[cell][d];
+            int player = box < 0 ? -1 : s->neighbours[box][d];
+            if (player < 0 || s->pullVisited[box] == s->stamp || hasBox(boxes, player))
+                continue;
+            s->pullVisited[box] = s->stamp;
+            if (hasBox(boxes, box)) s->boxList[numBoxes++] = box;
+            else s->queue[tail++] = box;
+        }
+    }
+    return numBoxes;
+}
+
+// breadth first over the cell the box is on and the side of it the player is
+// standing on, with the other boxes left where they are. returns the state
+// (cell * 4 + side) with the box on the goal, or -1 when it can't get there
+static int findPackingPath(Solver* s, uint64_t* boxes, int box, int goal, int player) {
+    int head = 0, tail = 0, found = -1;
+    int search = ++s->stamp;
+    reach(s, boxes, player, s->childVisited);
+    for (int side = 0; side < 4; side++) {
+        int cell = s->neighbours[box][side];
+        if (cell < 0 || s->childVisited[cell] != s->stamp) continue;
+        s->sideVisited[box * 4 + side] = search;
+        s->sideParents[box * 4 + side] = -1;
+        s->sideQueue[tail++] = box * 4 + side;
+    }
+
+    toggleBox(boxes, box);
+    while (head < tail && found == -1) {
+        int state = s->sideQueue[head++];
+        int cell = state / 4;
+        toggleBox(boxes, cell);
+        reach(s, boxes, s->neighbours[cell][state % 4], s->childVisited);
+        toggleBox(boxes, cell);
+
+        // the sides the player can walk between are the same state
+        for (int side = 0; side < 4; side++) {
+            int from = s->neighbours[cell][side];
+            int to = s->neighbours[cell][(side + 2) % 4];
+            if (from < 0 || s->childVisited[from] != s->stamp) continue;
+            if (s->sideVisited[cell * 4 + side] != search) {
+                s->sideVisited[cell * 4 + side] = search;
+                s->sideParents[cell * 4 + side] = s->sideParents[state];
+            }
+
+            int next = to * 4 + side;
+            if (to < 0 || hasBox(boxes, to) || (s->isDead[to] && s->spareBoxes == 0) ||
+                s->sideVisited[next] == search)
+                continue;
+            s->sideVisited[next] = search;
+            s->sideParents[next] = state;
+            s->sideQueue[tail++] = next;
+            if (to == goal) {
+                found = next;
+                break;
+            }
+        }
+    }
+    toggleBox(boxes, box);
+    return found;
+}
+
+// push the box along the path found by findPackingPath and return how many
+// pushes it took. the moves are written out too when there's somewhere to put them
+static int followPackingPath(Solver* s, uint64_t* boxes, int state, int* player, Moves* moves) {
+    int numCells = 0;
+    for (; state != -1; state = s->sideParents[state]) s->path[numCells++] = state / 4;
+
+    for (int i = numCells - 1; i > 0; i--) {
+        int at = s->path[i], next = s->path[i - 1], d = 0;
+        while (s->neighbours[at][d] != next) d++;
+        if (moves != NULL) {
+            appendWalk(s, moves, boxes, *player, s->neighbours[at][(d + 2) % 4]);
+            appendMove(moves, toupper(directionNames[d]));
+        }
+        toggleBox(boxes, at);
+        toggleBox(boxes, next);
+        *player = at;
+    }
+    return numCells - 1;
+}
+
+// the weight is how many pushes along the way weren't suggested
+static uint64_t openKey(int weight, int estimate, int node) {
+    if (weight > 0xffff) weight = 0xffff;
+    return ((uint64_t)weight << 44) | ((uint64_t)estimate << 28) | (uint32_t)node;
+}
+
+static bool isBackward(Solver* s, int node) {
+    return s->pushDirections[node] & BACKWARD_NODE;
+}
+
+// a node that's left out of the table, holding the step where the two searches meet
+static int addMeetingNode(Solver* s, int parent, int box, int direction) {
+    if (s->numNodes == s->capacity) return -1;
+    int node = s->numNodes++;
+    s->parents[node] = parent;
+    s->pushCells[node] = box;
+    s->pushDirections[node] = direction;
+    return node;
+}
+
+// store the boxes as a child of the forward node and queue it, returning the
+// child, -2 when it's been seen before or -1 when the search is out of memory
+static int addChild(
+    Solver* s, const uint64_t* boxes, int node, int box, int to, int player,
+    int direction, int weight, int packed, int regions) {
+    int childPlayer = reach(s, boxes, player, s->childVisited);
+    uint64_t hash = s->hashes[node] ^ s->boxKeys[box] ^ s->boxKeys[to] ^
+                    s->playerKeys[s->players[node]] ^ s->playerKeys[childPlayer];
+    size_t slot;
+    int found = findNode(s, boxes, hash, childPlayer, &slot);
+    if (found != -1) {
+        if (!isBackward(s, found)) return -2;
+        int step = addMeetingNode(s, node, box, direction);
+        s->meetForward = step;
+        s->meetBackward = found;
+        return step;
+    }
+
+    int child = addNode(s, boxes, hash, childPlayer, slot);
+    if (child == -1) return -1;
+    s->parents[child] = node;
+    s->pushCells[child] = box;
+    s->pushDirections[child] = direction;
+
+    int childPacked = countPacked(s, boxes);
+    if (childPacked == s->numGoals) {
+        s->meetForward = child;
+        return child;
+    }
+
+    // pushes that fill the next goal or open up the floor are free
+    int childRegions = countRegions(s, boxes);
+    if (direction != MACRO_PUSH && childPacked <= packed && childRegions >= regions)
+        weight++;
+
+    OpenList* list = &s->open[childPacked * MAX_REGIONS + childRegions];
+    int estimate = estimateCost(s, &s->goals, boxes);
+    return openPush(list, openKey(weight, estimate, child)) ? child : -1;
+}
+
+static void startForward(Solver* s) {
+    uint64_t hash = 0;
+    for (int i = 0; i < s->numCells; i++)
+        if (hasBox(s->startBoxes, i)) hash ^= s->boxKeys[i];
+
+    int player = reach(s, s->startBoxes, 0, s->visited);
+    hash ^= s->playerKeys[player];
+    size_t slot;
+    findNode(s, s->startBoxes, hash, player, &slot);
+    int root = addNode(s, s->startBoxes, hash, player, slot);
+    s->parents[root] = -1;
+    s->pushDirections[root] = 0;
+
+    int packed = countPacked(s, s->startBoxes);
+    if (packed == s->numGoals) {
+        s->meetForward = root;
+    } else if (!tooManyStuck(s, s->startBoxes)) {
+        OpenList* list = &s->open[packed * MAX_REGIONS + countRegions(s, s->startBoxes)];
+        openPush(list, openKey(0, estimateCost(s, &s->goals, s->startBoxes), root));
+    }
+}
+
+// the forward search loosely follows FESS. its open lists take turns, and the
+// node with the lowest weight then estimate goes first from each
+static void expandForward(Solver* s, int list) {
+    uint64_t key = openPop(&s->open[list]);
+    int node = key & 0xfffffff;
+    int weight = key >> 44;
+    int packed = list / MAX_REGIONS;
+    int regions = list % MAX_REGIONS;
+    uint64_t* current = s->current;
+    uint64_t* allowed = s->allowed;
+    s->nodesExpanded++;
+
+    memcpy(current, nodeBoxes(s, node), s->numWords * sizeof(uint64_t));
+    reach(s, current, s->players[node], s->visited);
+    int reachable = s->stamp;
+
+    memcpy(allowed, current, s->numWords * sizeof(uint64_t));
+    if (!pruneCorrals(s, current, reachable, allowed)) return;
+
+    for (int box = 0; box < s->numCells; box++) {
+        if (!hasBox(allowed, box)) continue;
+        for (int d = 0; d < 4; d++) {
+            int from = s->neighbours[box][(d + 2) % 4];
+            if (from < 0 || s->visited[from] != reachable) continue;
+
+            // the whole line of boxes moves, which is the same as
+            // taking the first box away and adding one after the last
+            int to = s->neighbours[box][d];
+            while (to >= 0 && hasBox(current, to))
+                to = s->neighbours[to][d];
+            if (to < 0 || (s->isDead[to] && s->spareBoxes == 0)) continue;
+
+            toggleBox(current, box);
+            toggleBox(current, to);
+            int child = -2;
+            if (!isDeadlocked(s, current, to))
+                child = addChild(s, current, node, box, to, box, d, weight, packed, regions);
+            toggleBox(current, to);
+            toggleBox(current, box);
+
+            s->outOfMemory = child == -1;
+            if (s->outOfMemory || s->meetForward != -1) return;
+        }
+    }
+
+    // push the closest box that can get there onto the next goal in one go,
+    // leaving the boxes that are already packed alone
+    int goal = s->packingOrder[packed];
+    int numBoxes = hasBox(current, goal) ? 0 : findPackingBoxes(s, current, goal);
+    int candidates[4], numCandidates = 0;
+    for (int i = 0; i < numBoxes && numCandidates < 4; i++) {
+        int box = s->boxList[i];
+        bool isPacked = false;
+        for (int j = 0; j < packed; j++) isPacked |= s->packingOrder[j] == box;
+        if (hasBox(allowed, box) && !isPacked) candidates[numCandidates++] = box;
+    }
+
+    for (int i = 0; i < numCandidates; i++) {
+        int box = candidates[i], standing = s->players[node];
+        int state = findPackingPath(s, current, box, goal, standing);
+        if (state == -1) continue;
+        followPackingPath(s, current, state, &standing, NULL);
+        int child = -2;
+        if (!isDeadlocked(s, current, goal))
+            child = addChild(
+                s, current, node, box, goal, standing, MACRO_PUSH, weight, packed, regions);
+        toggleBox(current, goal);
+        toggleBox(current, box);
+        s->outOfMemory = child == -1;
+        return;
+    }
+}
+
+// the backward search pulls boxes away from the solved level with weighted A*,
+// which suits the levels where the goals have to be filled in a careful order,
+// since taking boxes out of a goal room is easy. only single box pushes are
+// undone. the player can finish anywhere, so each area around the solved boxes
+// is a root. where spare boxes end up isn't known, so then it doesn't run
+static void startBackward(Solver* s) {
+    if (s->spareBoxes > 0) return;
+
+    uint64_t* current = s->current;
+    memset(current, 0, s->numWords * sizeof(uint64_t));
+    uint64_t boxHash = 0;
+    for (int i = 0; i < s->numCells; i++) {
+        if (!s->isGoal[i]) continue;
+        toggleBox(current, i);
+        boxHash ^= s->boxKeys[i];
+    }
+    int estimate = estimateCost(s, &s->starts, current);
+
+    s->stamp++;
+    int roots = s->stamp;
+    for (int i = 0; i < s->numCells; i++) {
+        if (hasBox(current, i) || s->childVisited[i] == roots) continue;
+        int player = reach(s, current, i, s->visited);
+        for (int j = 0; j < s->numCells; j++)
+            if (s->visited[j] == s->stamp) s->childVisited[j] = roots;
+
+        uint64_t hash = boxHash ^ s->playerKeys[player];
+        size_t slot;
+        findNode(s, current, hash, player, &slot);
+        int root = addNode(s, current, hash, player, slot);
+        if (root == -1) return;
+        s->parents[root] = -1;
+        s->pushDirections[root] = BACKWARD_NODE;
+        openPush(&s->backwardOpen, openKey(BACKWARD_WEIGHT * estimate, estimate, root));
+    }
+}
+
+static void expandBackward(Solver* s) {
+    uint64_t key = openPop(&s->backwardOpen);
+    int node = key & 0xfffffff;
+    int h = (key >> 28) & 0xffff;
+    int g = (key >> 44) - BACKWARD_WEIGHT * h;
+    uint64_t* current = s->current;
+    s->nodesExpanded++;
+
+    memcpy(current, nodeBoxes(s, node), s->numWords * sizeof(uint64_t));
+    reach(s, current, s->players[node], s->visited);
+    int reachable = s->stamp;
+
+    for (int box = 0; box < s->numCells; box++) {
+        if (!hasBox(current, box)) continue;
+        for (int d = 0; d < 4; d++) {
+            // the player steps back from the box, pulling it along
+            int to = s->neighbours[box][d];
+            if (to < 0 || s->visited[to] != reachable) continue;
+            int player = s->neighbours[to][d];
+            if (player < 0 || hasBox(current, player) ||
+                s->starts.minDistance[to] == UNREACHABLE)
+                continue;
+
+            toggleBox(current, box);
+            toggleBox(current, to);
+            int childPlayer = reach(s, current, player, s->childVisited);
+            uint64_t hash = s->hashes[node] ^ s->boxKeys[box] ^ s->boxKeys[to] ^
+                            s->playerKeys[s->players[node]] ^ s->playerKeys[childPlayer];
+            // kept as the push that undoes the pull
+            int direction = ((d + 2) % 4) | BACKWARD_NODE;
+            size_t slot;
+            int found = findNode(s, current, hash, childPlayer, &slot);
+            int child = -2;
+            if (found != -1 && !isBackward(s, found)) {
+                child = addMeetingNode(s, node, to, direction);
+                s->meetForward = found;
+                s->meetBackward = child;
+            } else if (found == -1) {
+                child = addNode(s, current, hash, childPlayer, slot);
+                if (child >= 0) {
+                    s->parents[child] = node;
+                    s->pushCells[child] = to;
+                    s->pushDirections[child] = direction;
+                    int estimate = estimateCost(s, &s->starts, current);
+                    int priority = g + 1 + BACKWARD_WEIGHT * estimate;
+                    if (!openPush(&s->backwardOpen, openKey(priority, estimate, child)))
+                        child = -1;
+                }
+            }
+            toggleBox(current, to);
+            toggleBox(current, box);
+
+            s->outOfMemory = child == -1;
+            if (s->outOfMemory || s->meetForward != -1) return;
+        }
+    }
+}
+
+// search forwards from the start and backwards from the solved level, until
+// they meet or one reaches the other's end
+static bool search(Solver* s) {
+    s->meetForward = s->meetBackward = -1;
+    startForward(s);
+    if (s->meetForward == -1) startBackward(s);
+
+    while (s->meetForward == -1 && !s->outOfMemory) {
+        int expanded = 0;
+        for (int list = 0; list < s->numOpen; list++) {
+            if (s->meetForward != -1 || s->outOfMemory) break;
+            if (s->open[list].size == 0) continue;
+            expandForward(s, list);
+            expanded++;
+        }
+
+        // the backward search keeps pace with the forward one
+        int turns = expanded > 0 ? expanded : 1;
+        for (int i = 0; i < turns && s->backwardOpen.size > 0; i++) {
+            if (s->meetForward != -1 || s->outOfMemory) break;
+            expandBackward(s);
+        }
+        if (expanded == 0 && s->backwardOpen.size == 0) break;
+    }
+    return s->meetForward != -1;
+}
+
+// replay the pushes from the start and fill in the walks between them. the
+// forward half is stored from its end back, the backward half in order
+static void buildMoves(Solver* s, Solution* solution) {
+    int numForward = 0, numSteps = 0;
+    for (int node = s->meetForward; s->parents[node] != -1; node = s->parents[node])
+        numForward++;
+    numSteps = numForward;
+    for (int node = s->meetBackward; node != -1 && s->parents[node] != -1;
+         node = s->parents[node])
+        numSteps++;
+
+    int* path = malloc((numSteps + 1) * sizeof(int));
+    int i = numForward;
+    for (int node = s->meetForward; s->parents[node] != -1; node = s->parents[node])
+        path[--i] = node;
+    i = numForward;
+    for (int node = s->meetBackward; node != -1 && s->parents[node] != -1;
+         node = s->parents[node])
+        path[i++] = node;
+
+    uint64_t* boxes = malloc(s->numWords * sizeof(uint64_t));
+    memcpy(boxes, s->startBoxes, s->numWords * sizeof(uint64_t));
+    Moves m = { NULL, 0, 0 };
+    int player = 0, numPushes = 0;
+
+    for (i = 0; i < numSteps; i++) {
+        int box = s->pushCells[path[i]];
+        int d = s->pushDirections[path[i]] & ~BACKWARD_NODE;
+        if (d == MACRO_PUSH) {
+            int target = s->packingOrder[countPacked(s, boxes)];
+            int state = findPackingPath(s, boxes, box, target, player);
+            numPushes += followPackingPath(s, boxes, state, &player, &m);
+            continue;
+        }
+
+        appendWalk(s, &m, boxes, player, s->neighbours[box][(d + 2) % 4]);
+        appendMove(&m, toupper(directionNames[d]));
+
+        int to = s->neighbours[box][d];
+        while (hasBox(boxes, to)) to = s->neighbours[to][d];
+        toggleBox(boxes, box);
+        toggleBox(boxes, to);
+        player = box;
+        numPushes++;
+    }
+
+    if (m.str == NULL) m.str = calloc(1, 1); // already solved
+    solution->solved = true;
+    solution->moves = m.str;
+    solution->numMoves = m.length;
+    solution->numPushes = numPushes;
+    free(boxes);
+    free(path);
+}
+
+Solution solveLevel(Level* level, int playerX, int playerY, size_t memoryLimit) {
+    Solution solution = { 0 };
+    Solver s = { 0 };
+
+    if (setupSolver(&s, level, playerX, playerY, memoryLimit)) {
+        if (search(&s)) buildMoves(&s, &solution);
+        solution.nodesExpanded = s.nodesExpanded;
+    }
+
+    cleanupSolver(&s);
+    return solution;
+}
+
+void freeSolution(Solution* solution) {
+    free(solution->moves);
+    *solution = (Solution){ 0 };
+}
+
+// the push planner searches over the planned box's cell and the side of it
+// the player is standing on, so there are four states per cell
+#define SIDE_UNKNOWN -2
+
+typedef struct {
+    Level* level;
+    int target;
+    int (*neighbours)[4]; // -1 when there's a wall or the edge of the level that way
+    short* sides; // walking distance between each pair of sides of each cell
+    uint64_t* costs; // best (pushes << 24 | steps) of each state, UINT64_MAX when unseen
+    int* parents; // state each one was pushed from, -1 for the ones the search starts at
+
+    uint64_t* heap; // keyed by (pushes, steps, state)
+    int heapSize;
+    int heapCapacity;
+
+    int stamp;
+    int* visited;
+    int* distance;
+    int* came; // direction taken to step onto each cell
+    int* queue;
+} Planner;
+
+static bool isOpen(Level* level, int index) {
+    return index != -1 && !isBox(level, index);
+}
+
+// fewest pushes the box could possibly take from a cell to the target
+static int pushEstimate(Planner* p, int cell) {
+    int width = p->level->width;
+    return abs(cell % width - p->target % width) + abs(cell / width - p->target / width);
+}
+
+// breadth first from a cell, going around the boxes and the box at boxCell.
+// stops once every cell in targets has been found, -1s in there are skipped
+static void walkFrom(Planner* p, int from, int boxCell, int* targets) {
+    int head = 0, tail = 0, remaining = 0;
+    for (int i = 0; i < 4; i++) remaining += targets[i] != -1;
+    p->stamp++;
+    p->visited[from] = p->stamp;
+    p->distance[from] = 0;
+    p->queue[tail++] = from;
+
+    while (head < tail && remaining > 0) {
+        int cell = p->queue[head++];
+        for (int i = 0; i < 4; i++) remaining -= targets[i] == cell;
+        for (int d = 0; d < 4; d++) {
+            int next = p->neighbours[cell][d];
+            if (!isOpen(p->level, next) || next == boxCell || p->visited[next] == p->stamp)
+                continue;
+            p->visited[next] = p->stamp;
+            p->distance[next] = p->distance[cell] + 1;
+            p->came[next] = d;
+            p->queue[tail++] = next;
+        }
+    }
+}
+
+static int walkDistance(Planner* p, int to) {
+    return to != -1 && p->visited[to] == p->stamp ? p->distance[to] : -1;
+}
+
+// steps between the sides of a box standing on a cell, worked out the first
+// time the search gets there. the distances go both ways, so each walk fills
+// in a row and a column
+static short* sideDistances(Planner* p, int cell) {
+    short* d = &p->sides[cell * 16];
+    int sides[4];
+    for (int s = 0; s < 4; s++) {
+        int side = p->neighbours[cell][s];
+        sides[s] = isOpen(p->level, side) ? side : -1;
+    }
+
+    for (int s = 0; s < 4; s++) {
+        bool missing = false;
+        for (int t = 0; t < 4; t++) missing |= d[s * 4 + t] == SIDE_UNKNOWN;
+        if (!missing) continue;
+        if (sides[s] != -1) walkFrom(p, sides[s], cell, sides);
+        for (int t = 0; t < 4; t++) {
+            int distance = sides[s] == -1 ? -1 : walkDistance(p, sides[t]);
+            d[s * 4 + t] = d[t * 4 + s] = distance;
+        }
+    }
+    return d;
+}
+
+// the open list is ordered by pushes plus the estimate, then by steps. a push
+// changes the estimate by one at most, so the first state on the target is the best
+static void reachState(Planner* p, int state, int parent, int pushes, int steps) {
+    uint64_t cost = ((uint64_t)pushes << 24) | steps;
+    if (cost >= p->costs[state]) return;
+    p->costs[state] = cost;
+    p->parents[state] = parent;
+    uint64_t priority = cost + ((uint64_t)pushEstimate(p, state / 4) << 24);
+
+    if (p->heapSize == p->heapCapacity) {
+        p->heapCapacity = p->heapCapacity ? p->heapCapacity * 2 : 256;
+        p->heap = realloc(p->heap, p->heapCapacity * sizeof(uint64_t));
+    }
+    uint64_t key = (priority << 24) | state;
+    int i = p->heapSize++;
+    while (i > 0 && p->heap[(i - 1) / 2] > key) {
+        p->heap[i] = p->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    p->heap[i] = key;
+}
+
+static uint64_t popState(Planner* p) {
+    uint64_t top = p->heap[0];
+    uint64_t last = p->heap[--p->heapSize];
+    int i = 0;
+    while (true) {
+        int child = i * 2 + 1;
+        if (child >= p->heapSize) break;
+        if (child + 1 < p->heapSize && p->heap[child + 1] < p->heap[child])
+            child++;
+        if (p->heap[child] >= last) break;
+        p->heap[i] = p->heap[child];
+        i = child;
+    }
+    p->heap[i] = last;
+    return top;
+}
+
+// a* over the states, returns the first one with the box on the target or -1
+static int planSearch(Planner* p, int player, int box, long* nodesExpanded) {
+    int sides[4];
+    for (int s = 0; s < 4; s++) {
+        int side = p->neighbours[box][s];
+        sides[s] = isOpen(p->level, side) ? side : -1;
+    }
+    walkFrom(p, player, box, sides);
+    for (int s = 0; s < 4; s++) {
+        int steps = walkDistance(p, sides[s]);
+        if (steps != -1) reachState(p, box * 4 + s, -1, 0, steps);
+    }
+
+    while (p->heapSize > 0) {
+        uint64_t key = popState(p);
+        int state = key & 0xffffff;
+        int cell = state / 4, side = state % 4;
+        uint64_t cost = (key >> 24) - ((uint64_t)pushEstimate(p, cell) << 24);
+        if (cost != p->costs[state]) continue; // a cheaper way here was found later
+        (*nodesExpanded)++;
+
+        if (cell == p->target) return state;
+        int pushes = cost >> 24, steps = cost & 0xffffff;
+
+        // walk around to a side, then push away from it
+        short* d = sideDistances(p, cell);
+        for (int t = 0; t < 4; t++) {
+            int walk = d[side * 4 + t];
+            int next = p->neighbours[cell][(t + 2) % 4];
+            if (walk < 0 || !isOpen(p->level, next)) continue;
+            reachState(p, next * 4 + t, state, pushes + 1, steps + walk + 1);
+        }
+    }
+    return -1;
+}
+
+// append the shortest walk between two cells, going around the box at boxCell
+static void appendPlannedWalk(Planner* p, Moves* m, int from, int to, int boxCell) {
+    int targets[4] = { to, -1, -1, -1 };
+    walkFrom(p, from, boxCell, targets);
+
+    int length = 0;
+    for (int cell = to; cell != from; length++) {
+        p->queue[length] = p->came[cell];
+        cell = p->neighbours[cell][(p->came[cell] + 2) % 4];
+    }
+    while (length > 0)
+        appendMove(m, directionNames[p->queue[--length]]);
+}
+
+static void buildPlan(Planner* p, int player, int goal, Solution* solution) {
+    int numStates = 0;
+    for (int state = goal; state != -1; state = p->parents[state]) numStates++;
+    int* path = malloc(numStates * sizeof(int));
+    int i = numStates;
+    for (int state = goal; state != -1; state = p->parents[state]) path[--i] = state;
+
+    Moves m = { NULL, 0, 0 };
+    int cell = path[0] / 4;
+    appendPlannedWalk(p, &m, player, p->neighbours[cell][path[0] % 4], cell);
+    for (i = 1; i < numStates; i++) {
+        int from = path[i - 1] % 4, to = path[i] % 4;
+        appendPlannedWalk(
+            p, &m, p->neighbours[cell][from], p->neighbours[cell][to], cell);
+        appendMove(&m, toupper(directionNames[(to + 2) % 4]));
+        cell = path[i] / 4;
+    }
+
+    if (m.str == NULL) m.str = calloc(1, 1);
+    solution->solved = true;
+    solution->moves = m.str;
+    solution->numMoves = m.length;
+    solution->numPushes = numStates - 1;
+    free(path);
+}
+
+Solution planPush(Level* level, int player, int box, int target) {
+    Solution solution = { 0 };
+    int numCells = level->width * level->height;
+    if (box < 0 || box >= numCells || !isBox(level, box) || target < 0 ||
+        target >= numCells || isWall(level, target) || (isBox(level, target) && target != box) ||
+        numCells * 4 > 0xffffff) // a state has to fit in 24 bits
+        return solution;
+    if (box == target) {
+        solution.solved = true;
+        solution.moves = calloc(1, 1);
+        return solution;
+    }
+
+    Planner p = { .level = level, .target = target };
+    p.neighbours = malloc(numCells * sizeof(*p.neighbours));
+    for (int i = 0; i < numCells; i++) {
+        for (int d = 0; d < 4; d++) {
+            int x = i % level->width + directionX[d];
+            int y = i / level->width + directionY[d];
+            bool inside = x >= 0 && y >= 0 && x < level->width && y < level->height;
+            int next = y * level->width + x;
+            p.neighbours[i][d] = inside && !isWall(level, next) ? next : -1;
+        }
+    }
+    p.sides = malloc(numCells * 16 * sizeof(short));
+    p.costs = malloc(numCells * 4 * sizeof(uint64_t));
+    p.parents = malloc(numCells * 4 * sizeof(int));
+    p.visited = calloc(numCells, sizeof(int));
+    p.distance = malloc(numCells * sizeof(int));
+    p.came = malloc(numCells * sizeof(int));
+    p.queue = malloc(numCells * sizeof(int));
+    for (int i = 0; i < numCells * 16; i++) p.sides[i] = SIDE_UNKNOWN;
+    memset(p.costs, 0xff, numCells * 4 * sizeof(uint64_t));
+
+    // the box is in the way wherever the search has it, not where it started
+    toggleBox(level->boxes, box);
+    int goal = planSearch(&p, player, box, &solution.nodesExpanded);
+    if (goal != -1) buildPlan(&p, player, goal, &solution);
+    toggleBox(level->boxes, box);
+
+    free(p.neighbours);
+    free(p.sides);
+    free(p.costs);
+    free(p.parents);
+    free(p.heap);
+    free(p.visited);
+    free(p.distance);
+    free(p.came);
+    free(p.queue);
+    return solution;
+}
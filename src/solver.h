@@ -0,0 +1,26 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stddef.h>
+#include "levels.h"
+
+// upper bound on the memory the search is allowed to use (nodes + transposition table)
+#define SOLVER_MEMORY_LIMIT (64 << 20)
+
+typedef struct {
+    bool solved;
+    char* moves; // LURD string, lowercase for walks and uppercase for pushes
+    int numMoves;
+    int numPushes;
+    long nodesExpanded;
+} Solution;
+
+// find a solution for the level with the player standing at (playerX, playerY)
+Solution solveLevel(Level* level, int playerX, int playerY, size_t memoryLimit);
+void freeSolution(Solution* solution);
+
+// fewest pushes, then fewest steps, to get one box onto the target cell with
+// the player starting at the player cell. the other boxes are left where they are
+Solution planPush(Level* level, int player, int box, int target);
+
+#endif
@@ -0,0 +1,295 @@
+// chickoban-bench: times the hot paths, compares them against a baseline
+// file and exits with 1 when something got slower than the threshold
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "levels.h"
+#include "game.h"
+#include "pack.h"
+
+#define MAX_BENCHMARKS 16
+#define SYNTHETIC_COPIES 200 // copies of levels.txt, 10,000 levels in all
+
+typedef struct {
+    const char* name;
+    double p50, p90, p99; // nanoseconds per operation
+} Result;
+
+typedef struct {
+    int numSamples;
+    Result results[MAX_BENCHMARKS];
+    int numResults;
+} Bench;
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void addResult(Bench* bench, const char* name, double* samples) {
+    qsort(samples, bench->numSamples, sizeof(double), compareDoubles);
+    int last = bench->numSamples - 1;
+    Result r = {
+        name, samples[(int)(last * 0.5)], samples[(int)(last * 0.9)],
+        samples[(int)(last * 0.99)]
+    };
+    bench->results[bench->numResults++] = r;
+    printf("%-22s p50 %12.1f  p90 %12.1f  p99 %12.1f  ns/op\n", name, r.p50, r.p90, r.p99);
+}
+
+static void benchParse(Bench* bench, const char* name, char* path) {
+    double* samples = malloc(bench->numSamples * sizeof(double));
+
+    for (int s = 0; s < bench->numSamples; s++) {
+        Collection collection;
+        double start = now();
+        loadCollection(path, &collection);
+        samples[s] = (now() - start) * 1e9;
+        freeCollection(&collection);
+    }
+
+    addResult(bench, name, samples);
+    free(samples);
+}
+
+// the same collection written out many times over
+static void benchSyntheticParse(Bench* bench, char* path) {
+    FILE* in = fopen(path, "rb");
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    rewind(in);
+    char* contents = malloc(size);
+    size = fread(contents, 1, size, in);
+    fclose(in);
+    while (size > 0 && contents[size - 1] == '\n') size--;
+
+    char synthetic[] = "/tmp/chickoban-bench-XXXXXX";
+    int fd = mkstemp(synthetic);
+    FILE* out = fdopen(fd, "wb");
+    for (int i = 0; i < SYNTHETIC_COPIES; i++) {
+        fwrite(contents, 1, size, out);
+        fputs("\n\n", out);
+    }
+    fclose(out);
+    free(contents);
+
+    benchParse(bench, "parse/synthetic", synthetic);
+    unlink(synthetic);
+}
+
+// what changeLevel pays to get a level out of the pack
+static void benchPackDecode(Bench* bench, Collection* collection) {
+    const int batch = 1000;
+    LevelPack pack;
+    packCollection(collection, &pack);
+    double* samples = malloc(bench->numSamples * sizeof(double));
+
+    for (int s = 0; s < bench->numSamples; s++) {
+        double start = now();
+        for (int i = 0; i < batch; i++) {
+            Level level;
+            loadPackedLevel(&pack, (s * batch + i) % pack.numLevels, &level);
+            cleanupLevel(&level);
+        }
+        samples[s] = (now() - start) * 1e9 / batch;
+    }
+
+    addResult(bench, "pack/decode", samples);
+    free(samples);
+    closePack(&pack);
+}
+
+// random walks over every level, restarting them every so often
+static void benchMoves(Bench* bench, Level* levels, int numLevels) {
+    const int batch = 100000;
+    const int deltaX[4] = { -1, 0, 1, 0 };
+    const int deltaY[4] = { 0, -1, 0, 1 };
+    double* samples = malloc(bench->numSamples * sizeof(double));
+    unsigned int seed = 1;
+    long moved = 0;
+
+    for (int s = 0; s < bench->numSamples; s++) {
+        Level* level = &levels[s % numLevels];
+        restartLevel(level);
+        int player = level->playerStartY * level->width + level->playerStartX;
+
+        double start = now();
+        for (int i = 0; i < batch; i++) {
+            seed = seed * 1103515245 + 12345;
+            int d = (seed >> 16) & 3;
+            moved += makeMove(level, &player, deltaX[d], deltaY[d]);
+        }
+        samples[s] = (now() - start) * 1e9 / batch;
+    }
+
+    addResult(bench, "moves", samples);
+    free(samples);
+    if (moved == 0) printf("the player never moved\n"); // keeps the loop from being optimized out
+}
+
+static void benchWinCheck(Bench* bench, Level* levels, int numLevels) {
+    const int batch = 1000000;
+    double* samples = malloc(bench->numSamples * sizeof(double));
+    volatile int solved = 0;
+
+    for (int s = 0; s < bench->numSamples; s++) {
+        Level* level = &levels[s % numLevels];
+        double start = now();
+        for (int i = 0; i < batch; i++)
+            solved += isSolved(level) + countCompletedGoals(level);
+        samples[s] = (now() - start) * 1e9 / batch;
+    }
+
+    addResult(bench, "win-check", samples);
+    free(samples);
+}
+
+// draw the biggest level into an offscreen texture. mesa's software
+// rasterizer keeps the numbers independent of the gpu
+static void benchRender(Bench* bench, Level* levels, int numLevels) {
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(640, 480, "chickoban-bench");
+
+    Game* game = createGame();
+    memset(game->assets->data.solvedLevels, 0, sizeof(game->assets->data.solvedLevels));
+    int biggest = 0;
+    for (int i = 0; i < numPlayableLevels(game) && i < numLevels; i++) {
+        Level* a = &levels[i];
+        Level* b = &levels[biggest];
+        if (a->width * a->height > b->width * b->height) biggest = i;
+    }
+    changeLevel(game, biggest, false);
+    game->frameTime = 1.0 / 60;
+
+    RenderTexture2D target = LoadRenderTexture(640, 480);
+    double* samples = malloc(bench->numSamples * sizeof(double));
+    for (int s = 0; s < bench->numSamples; s++) {
+        double start = now();
+        BeginTextureMode(target);
+        ClearBackground((Color){ 160, 210, 235, 255 });
+        updateCamera(game);
+        BeginMode3D(game->camera);
+        BeginShaderMode(game->assets->shader);
+        drawGame(game);
+        EndShaderMode();
+        EndMode3D();
+        EndTextureMode();
+
+        // reading the pixels back waits for the frame to finish
+        Image frame = LoadImageFromTexture(target.texture);
+        samples[s] = (now() - start) * 1e9;
+        UnloadImage(frame);
+    }
+
+    addResult(bench, "render/frame", samples);
+    free(samples);
+    UnloadRenderTexture(target);
+    cleanupGame(game);
+    CloseWindow();
+}
+
+static void saveBaseline(Bench* bench, char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "couldn't write to %s\n", path);
+        return;
+    }
+    fprintf(file, "# median nanoseconds per operation, written by chickoban-bench -s\n");
+    for (int i = 0; i < bench->numResults; i++)
+        fprintf(file, "%s %.1f\n", bench->results[i].name, bench->results[i].p50);
+    fclose(file);
+}
+
+// returns the number of benchmarks whose median got slower than the threshold
+static int compareBaseline(Bench* bench, char* path, double threshold) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "couldn't read %s\n", path);
+        return 0;
+    }
+
+    int regressions = 0;
+    char line[256], name[128];
+    double baseline;
+    printf("\ncompared to %s:\n", path);
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || sscanf(line, "%127s %lf", name, &baseline) != 2) continue;
+        for (int i = 0; i < bench->numResults; i++) {
+            Result* r = &bench->results[i];
+            if (strcmp(r->name, name) != 0) continue;
+
+            double change = (r->p50 - baseline) / baseline * 100;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            printf("%-22s %+7.1f%%%s\n", name, change, regressed ? "  REGRESSION" : "");
+        }
+    }
+    fclose(file);
+    return regressions;
+}
+
+static void usage(char* program) {
+    fprintf(stderr,
+            "usage: %s [-r] [-n samples] [-b baseline] [-s baseline] [-t percent] [levels.txt]\n"
+            "  -r  also time a frame of drawGame, needs a display\n"
+            "  -n  samples per benchmark, defaults to 200\n"
+            "  -b  compare the medians against a baseline file\n"
+            "  -s  save the medians as a new baseline\n"
+            "  -t  slowdown in percent that counts as a regression, defaults to 10\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    Bench bench = { .numSamples = 200 };
+    bool render = false;
+    char* baselinePath = NULL;
+    char* savePath = NULL;
+    double threshold = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "rn:b:s:t:h")) != -1) {
+        switch (opt) {
+            case 'r': render = true; break;
+            case 'n': bench.numSamples = atoi(optarg); break;
+            case 'b': baselinePath = optarg; break;
+            case 's': savePath = optarg; break;
+            case 't': threshold = atof(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (bench.numSamples < 1) bench.numSamples = 1;
+    char* path = optind < argc ? argv[optind] : "assets/levels.txt";
+
+    Collection collection;
+    int numLevels = loadCollection(path, &collection);
+    if (numLevels <= 0) {
+        fprintf(stderr, "couldn't read %s\n", path);
+        return 1;
+    }
+    Level* levels = collection.levels;
+
+    benchParse(&bench, "parse/levels.txt", path);
+    benchSyntheticParse(&bench, path);
+    benchMoves(&bench, levels, numLevels);
+    benchWinCheck(&bench, levels, numLevels);
+    benchPackDecode(&bench, &collection);
+    if (render) benchRender(&bench, levels, numLevels);
+
+    freeCollection(&collection);
+
+    if (savePath) saveBaseline(&bench, savePath);
+    int regressions = baselinePath ? compareBaseline(&bench, baselinePath, threshold) : 0;
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+// chickoban-pack: compiles a collection file into a level pack the game
+// can map instead of parsing
+#include <stdio.h>
+
+#include "levels.h"
+#include "pack.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s collection.txt levels.pack\n", argv[0]);
+        return 1;
+    }
+
+    Collection collection;
+    int numLevels = loadCollection(argv[1], &collection);
+    if (numLevels == -1) {
+        fprintf(stderr, "couldn't read %s\n", argv[1]);
+        return 1;
+    }
+
+    int result = writePack(argv[2], &collection);
+    if (result == -1) fprintf(stderr, "couldn't write to %s\n", argv[2]);
+    else fprintf(stderr, "packed %d levels into %s\n", numLevels, argv[2]);
+    freeCollection(&collection);
+    return result == -1 ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+// chickoban-solve: runs the solver over every level in a collection file
+// on all cores and writes the results as csv, json or lurd. it can also
+// check a file of lurd solutions against the collection
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "levels.h"
+#include "solver.h"
+
+typedef struct {
+    Solution solution;
+    double seconds;
+} Result;
+
+// each worker owns a deque of level indexes. it takes work from the back
+// of its own deque and steals from the front of the others when it runs out
+typedef struct {
+    pthread_mutex_t lock;
+    int* items;
+    int front;
+    int back;
+} Deque;
+
+typedef struct {
+    Level* levels;
+    Result* results;
+    Deque* deques;
+    int numWorkers;
+    size_t memoryLimit;
+} Pool;
+
+typedef struct {
+    Pool* pool;
+    int id;
+} Worker;
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int popBack(Deque* d) {
+    int item = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->back > d->front) item = d->items[--d->back];
+    pthread_mutex_unlock(&d->lock);
+    return item;
+}
+
+static int popFront(Deque* d) {
+    int item = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->back > d->front) item = d->items[d->front++];
+    pthread_mutex_unlock(&d->lock);
+    return item;
+}
+
+static int nextLevel(Pool* pool, int id) {
+    int item = popBack(&pool->deques[id]);
+    for (int i = 1; i < pool->numWorkers && item == -1; i++)
+        item = popFront(&pool->deques[(id + i) % pool->numWorkers]);
+    return item;
+}
+
+static void* work(void* data) {
+    Worker* worker = data;
+    Pool* pool = worker->pool;
+
+    int index;
+    while ((index = nextLevel(pool, worker->id)) != -1) {
+        Level* level = &pool->levels[index];
+        double start = now();
+        pool->results[index].solution = solveLevel(
+            level, level->playerStartX, level->playerStartY, pool->memoryLimit);
+        pool->results[index].seconds = now() - start;
+    }
+    return NULL;
+}
+
+static void writeCsv(FILE* out, Result* results, int numLevels) {
+    fprintf(out, "level,solved,pushes,moves,nodes,seconds,solution\n");
+    for (int i = 0; i < numLevels; i++) {
+        Solution* s = &results[i].solution;
+        fprintf(out, "%d,%d,%d,%d,%ld,%.6f,%s\n", i + 1, s->solved, s->numPushes,
+                s->numMoves, s->nodesExpanded, results[i].seconds,
+                s->solved ? s->moves : "");
+    }
+}
+
+static void writeJson(FILE* out, Result* results, int numLevels) {
+    fprintf(out, "[\n");
+    for (int i = 0; i < numLevels; i++) {
+        Solution* s = &results[i].solution;
+        fprintf(out,
+                "  {\"level\": %d, \"solved\": %s, \"pushes\": %d, \"moves\": %d, "
+                "\"nodes\": %ld, \"seconds\": %.6f, \"solution\": \"%s\"}%s\n",
+                i + 1, s->solved ? "true" : "false", s->numPushes, s->numMoves,
+                s->nodesExpanded, results[i].seconds, s->solved ? s->moves : "",
+                i + 1 < numLevels ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+// a "Level N" line for each solved level, then its moves and a blank line
+static void writeLurdFile(FILE* out, Result* results, int numLevels) {
+    for (int i = 0; i < numLevels; i++) {
+        Solution* s = &results[i].solution;
+        if (s->solved) fprintf(out, "Level %d\n%s\n\n", i + 1, s->moves);
+    }
+}
+
+typedef struct {
+    char* str;
+    int length;
+    int capacity;
+} Moves;
+
+static void appendMoves(Moves* m, const char* line, int length) {
+    if (m->length + length > m->capacity) {
+        m->capacity = (m->length + length) * 2;
+        m->str = realloc(m->str, m->capacity);
+    }
+    memcpy(m->str + m->length, line, length);
+    m->length += length;
+}
+
+// replays the moves collected so far and writes a csv row for them
+static bool checkSolution(FILE* out, Level* levels, int numLevels, int level, Moves* m) {
+    int numMoves = 0, numPushes = 0;
+    bool valid = level >= 1 && level <= numLevels &&
+                 replayLurd(&levels[level - 1], m->str, m->length, &numMoves, &numPushes);
+    fprintf(out, "%d,%d,%d,%d\n", level, valid, numMoves, numPushes);
+    m->length = 0;
+    return valid;
+}
+
+// streams a solutions file: a "Level N" line starts the solutions for a
+// level and blank lines separate them. moves can be wrapped over several
+// lines, other lines (titles, authors and so on) are skipped
+static int verifySolutions(FILE* in, FILE* out, Level* levels, int numLevels, int* numChecked) {
+    fprintf(out, "level,valid,moves,pushes\n");
+    char* line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    Moves m = { NULL, 0, 0 };
+    int level = 0, number, invalid = 0;
+
+    while ((length = getline(&line, &size, in)) != -1) {
+        bool header = sscanf(line, "Level %d", &number) == 1;
+        bool blank = strspn(line, " \t\r\n") == (size_t)length;
+        if (header || blank) {
+            if (m.length > 0) {
+                invalid += !checkSolution(out, levels, numLevels, level, &m);
+                (*numChecked)++;
+            }
+            if (header) level = number;
+            continue;
+        }
+        if (level != 0 && strspn(line, "lurdLURD \t\r\n") == (size_t)length)
+            appendMoves(&m, line, length);
+    }
+    if (m.length > 0) {
+        invalid += !checkSolution(out, levels, numLevels, level, &m);
+        (*numChecked)++;
+    }
+
+    free(line);
+    free(m.str);
+    return invalid;
+}
+
+static void usage(char* program) {
+    fprintf(stderr,
+            "usage: %s [-j threads] [-m megabytes] [-f csv|json|lurd] [-v solutions]\n"
+            "          [-o output] collection.txt\n"
+            "  -j  worker threads, defaults to one per core\n"
+            "  -m  memory limit for each search, defaults to %d\n"
+            "  -f  output format, defaults to csv\n"
+            "  -v  check the lurd solutions in a file instead of solving, - reads stdin\n"
+            "  -o  output file, defaults to stdout\n",
+            program, SOLVER_MEMORY_LIMIT >> 20);
+}
+
+int main(int argc, char** argv) {
+    int numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t memoryLimit = SOLVER_MEMORY_LIMIT;
+    char* format = "csv";
+    char* outputPath = NULL;
+    char* solutionsPath = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:m:f:v:o:h")) != -1) {
+        switch (opt) {
+            case 'j': numWorkers = atoi(optarg); break;
+            case 'm': memoryLimit = (size_t)atol(optarg) << 20; break;
+            case 'f': format = optarg; break;
+            case 'v': solutionsPath = optarg; break;
+            case 'o': outputPath = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (numWorkers < 1) numWorkers = 1;
+
+    char* path = argv[optind];
+    Collection collection;
+    int numLevels = loadCollection(path, &collection);
+    if (numLevels == -1) {
+        fprintf(stderr, "couldn't read %s\n", path);
+        return 1;
+    }
+    Level* levels = collection.levels;
+
+    FILE* out = outputPath ? fopen(outputPath, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "couldn't write to %s\n", outputPath);
+        return 1;
+    }
+
+    if (solutionsPath != NULL) {
+        bool fromStdin = strcmp(solutionsPath, "-") == 0;
+        FILE* in = fromStdin ? stdin : fopen(solutionsPath, "r");
+        if (in == NULL) {
+            fprintf(stderr, "couldn't read %s\n", solutionsPath);
+            return 1;
+        }
+
+        int checked = 0;
+        double start = now();
+        int invalid = verifySolutions(in, out, levels, numLevels, &checked);
+        fprintf(stderr, "%d / %d solutions valid, checked in %.2fs\n",
+                checked - invalid, checked, now() - start);
+
+        if (!fromStdin) fclose(in);
+        if (out != stdout) fclose(out);
+        freeCollection(&collection);
+        return invalid > 0 ? 1 : 0;
+    }
+
+    // deal the levels out round robin, stealing evens out the rest
+    Pool pool = {
+        .levels = levels,
+        .results = calloc(numLevels, sizeof(Result)),
+        .deques = calloc(numWorkers, sizeof(Deque)),
+        .numWorkers = numWorkers,
+        .memoryLimit = memoryLimit,
+    };
+    for (int i = 0; i < numWorkers; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].items = malloc((numLevels / numWorkers + 1) * sizeof(int));
+    }
+    for (int i = 0; i < numLevels; i++) {
+        Deque* d = &pool.deques[i % numWorkers];
+        d->items[d->back++] = i;
+    }
+
+    double start = now();
+    pthread_t* threads = malloc(numWorkers * sizeof(pthread_t));
+    Worker* workers = malloc(numWorkers * sizeof(Worker));
+    for (int i = 0; i < numWorkers; i++) {
+        workers[i] = (Worker){ &pool, i };
+        pthread_create(&threads[i], NULL, work, &workers[i]);
+    }
+    for (int i = 0; i < numWorkers; i++)
+        pthread_join(threads[i], NULL);
+    double elapsed = now() - start;
+
+    if (strcmp(format, "json") == 0) writeJson(out, pool.results, numLevels);
+    else if (strcmp(format, "lurd") == 0) writeLurdFile(out, pool.results, numLevels);
+    else writeCsv(out, pool.results, numLevels);
+    if (out != stdout) fclose(out);
+
+    int solved = 0;
+    for (int i = 0; i < numLevels; i++)
+        solved += pool.results[i].solution.solved;
+    fprintf(stderr, "solved %d / %d levels in %.2fs on %d threads\n",
+            solved, numLevels, elapsed, numWorkers);
+
+    for (int i = 0; i < numLevels; i++)
+        freeSolution(&pool.results[i].solution);
+    for (int i = 0; i < numWorkers; i++) {
+        pthread_mutex_destroy(&pool.deques[i].lock);
+        free(pool.deques[i].items);
+    }
+    free(pool.deques);
+    free(pool.results);
+    free(threads);
+    free(workers);
+    freeCollection(&collection);
+    return 0;
+}